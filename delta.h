@@ -0,0 +1,189 @@
+#pragma once
+
+// Delta compression of packed boards, shared by the game (recording) and the player.
+//
+// A packed board is an array of 64 bits words, cell `i` (row major) being bit `i % 64` of word `i / 64`.
+// Generations are compressed by XORing them with the previous one, which leaves mostly zero words on a
+// settled board, and run length encoding those zero words. A keyframe is simply the delta against an
+// empty board.
+//
+// The encoded stream is a sequence of runs, each made of:
+//
+//	varint	number of zero words
+//	varint	number of literal words
+//	u64 *	the literal words
+//
+// Recordings are made of a `DeltaFileHeader` followed by records, each made of a `DeltaRecord` and its
+// encoded payload. The offsets of the keyframes are written in a separate index file (`<recording>.idx`)
+// made of `DeltaIndexEntry`, which lets the player seek without scanning the whole recording.
+//
+// The tools reading packed boards also share the hash of their cells (`delta_hash_cells`, the same as the
+// game's `hash_cells`) and `sleep_ms` from here.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+
+#define DELTA_MAGIC		0x524c4f47 // "GOLR"
+#define DELTA_VERSION	1
+
+enum {
+	DELTA_RECORD_DELTA		= 0,
+	DELTA_RECORD_KEYFRAME	= 1,
+};
+
+typedef struct {
+	uint32_t	magic;
+	uint32_t	version;
+	uint32_t	width;
+	uint32_t	height;
+	uint32_t	keyframe_interval;
+	uint32_t	reserved;
+} DeltaFileHeader;
+
+typedef struct {
+	uint64_t	generation;
+	uint32_t	type;
+	uint32_t	size;
+} DeltaRecord;
+
+typedef struct {
+	uint64_t	generation;
+	uint64_t	offset;
+} DeltaIndexEntry;
+
+
+// Number of words of a packed board.
+static inline size_t
+delta_word_count(size_t width, size_t height)
+{
+	return (width * height + 63) / 64;
+}
+
+// Worst case size of an encoded board of `count` words.
+static inline size_t
+delta_encode_bound(size_t count)
+{
+	return count * 8 + 20;
+}
+
+static inline uint64_t
+delta_popcount(uint64_t word)
+{
+	word = word - ((word >> 1) & 0x5555555555555555ull);
+	word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+	word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0full;
+	return (word * 0x0101010101010101ull) >> 56;
+}
+
+// FNV-1a hash of cells, one cell at a time: `delta_hash_cell` adds a cell to `hash`, which starts at
+// `DELTA_HASH_BASIS`.
+#define DELTA_HASH_BASIS	0xcbf29ce484222325ull
+
+static inline uint64_t
+delta_hash_cell(uint64_t hash, uint64_t alive)
+{
+	return (hash ^ alive) * 0x100000001b3ull;
+}
+
+// Hash of the `size` cells of the packed board `words`.
+static inline uint64_t
+delta_hash_cells(const uint64_t *words, size_t size)
+{
+	uint64_t hash = DELTA_HASH_BASIS;
+	for (size_t i = 0; i != size; ++i) {
+		hash = delta_hash_cell(hash, (words[i / 64] >> (i % 64)) & 1);
+	}
+	return hash;
+}
+
+static inline void
+sleep_ms(int milliseconds)
+{
+	struct timespec duration = { milliseconds / 1000, (milliseconds % 1000) * 1000000L };
+	nanosleep(&duration, NULL);
+}
+
+static inline uint8_t *
+delta_put_varint(uint8_t *out, uint64_t value)
+{
+	while (value >= 0x80) {
+		*out++ = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	*out++ = (uint8_t)value;
+	return out;
+}
+
+static inline const uint8_t *
+delta_get_varint(const uint8_t *in, const uint8_t *end, uint64_t *value)
+{
+	*value = 0;
+	for (int shift = 0; in != end && shift < 64; shift += 7) {
+		uint8_t byte = *in++;
+		*value |= (uint64_t)(byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0) {
+			return in;
+		}
+	}
+	return NULL;
+}
+
+// Encodes `current ^ previous` (or `current` if `previous` is NULL) into `out`, which must hold at least
+// `delta_encode_bound(count)` bytes. Returns the size of the encoded data.
+static inline size_t
+delta_encode(const uint64_t *current, const uint64_t *previous, size_t count, uint8_t *out)
+{
+	uint8_t *begin = out;
+	size_t i = 0;
+	while (i != count) {
+		size_t zeros = i;
+		while (i != count && (current[i] ^ (previous ? previous[i] : 0)) == 0) {
+			++i;
+		}
+		zeros = i - zeros;
+
+		size_t literals = i;
+		while (i != count && (current[i] ^ (previous ? previous[i] : 0)) != 0) {
+			++i;
+		}
+		literals = i - literals;
+
+		out = delta_put_varint(out, zeros);
+		out = delta_put_varint(out, literals);
+		for (size_t j = i - literals; j != i; ++j) {
+			uint64_t word = current[j] ^ (previous ? previous[j] : 0);
+			memcpy(out, &word, 8);
+			out += 8;
+		}
+	}
+	return (size_t)(out - begin);
+}
+
+// XORs the encoded delta into `words`. Decoding a keyframe thus requires a zeroed `words`, and decoding a
+// delta requires the previous generation. Since XOR is its own inverse, applying a delta to the generation
+// it leads to gives back the previous one. Returns false if the data is corrupted.
+static inline bool
+delta_apply(const uint8_t *data, size_t size, uint64_t *words, size_t count)
+{
+	const uint8_t *end = data + size;
+	size_t i = 0;
+	while (data != end) {
+		uint64_t zeros, literals;
+		if ((data = delta_get_varint(data, end, &zeros)) == NULL ||
+			(data = delta_get_varint(data, end, &literals)) == NULL ||
+			zeros > count - i || literals > count - i - zeros || (size_t)(end - data) < literals * 8) {
+			return false;
+		}
+		i += zeros;
+		for (uint64_t j = 0; j != literals; ++j, ++i, data += 8) {
+			uint64_t word;
+			memcpy(&word, data, 8);
+			words[i] ^= word;
+		}
+	}
+	return i == count;
+}
@@ -1,53 +1,3686 @@
+// For sync_file_range.
+#define _GNU_SOURCE
+
 #include "raylib.h"
+#include "delta.h"
+#include "ltl.h"
+#include "rule.h"
+#include "shm_board.h"
+#include "stream.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+
+static char *	cells				= NULL;
+static int		cell_target_size	= 2;
+static int64_t	cell_count_w		= 0;
+static int64_t	cell_count_h		= 0;
+static uint8_t *	dirty				= NULL;
+static int64_t	dirty_w				= 0;
+static int64_t	dirty_h				= 0;
+static Vector2	cell_size			= { 0 };
+static int		cell_prob			= (int)(50.0 * (double)RAND_MAX / 100.0);
+static uint32_t	cell_seed			= 0;
+static int		block_gens			= 1;
+static Rule		rule				= RULE_CONWAY;
+static uint64_t	rule_serial			= 0;
+static char		rule_next[2][9]		= { 0 };
+static uint8_t	rule_lut[1 << 16]	= { 0 };
+static uint8_t	rule_sum_next[2][LTL_MAX_COUNT + 1] = { 0 };
+static int		engine				= 0;
+static uint64_t	generation			= 0;
+static bool		huge_pages			= false;
+
+
+#define ALIVE_MASK_1	(1 << 7)
+#define ALIVE_MASK_2	(1 << 6)
+#define CELL(x, y)		(cells[mod((y), cell_count_h) * cell_count_w + mod((x), cell_count_w)])
+
+// Tile size of the temporally blocked stepper. Including its halo, the two scratch buffers of a tile
+// are around 2 * 256 KB, which fits in the L2 / L3 of anything recent.
+#define BLOCK_TILE_W	512
+#define BLOCK_TILE_H	256
+#define BLOCK_MAX_GENS	16
+
+// Alignment of the board: a cache line, which is also the widest vector load. With huge pages, the board
+// is aligned on a (2 MB) huge page so that the kernel can back it entirely with them.
+#define CELLS_ALIGNMENT			64
+#define CELLS_HUGE_PAGE_SIZE	(2 << 20)
+
+
+static int64_t
+mod(int64_t a, int64_t b)
+{
+	a = a % b;
+	return a < 0 ? a + b : a;
+}
+
+
+// Allocates a board of `size` bytes, aligned for vector loads. If `huge_pages` is set, the kernel is also
+// asked to back it with transparent huge pages, which cuts the TLB misses on multi-gigabyte boards.
+static char *
+alloc_cells(size_t size)
+{
+	size_t alignment = huge_pages && size >= CELLS_HUGE_PAGE_SIZE ? CELLS_HUGE_PAGE_SIZE : CELLS_ALIGNMENT;
+	void *memory = NULL;
+	if (posix_memalign(&memory, alignment, (size + alignment - 1) / alignment * alignment) != 0) {
+		fprintf(stderr, "Couldn't allocate a board of %zu bytes.\n", size);
+		exit(1);
+	}
+#ifdef MADV_HUGEPAGE
+	if (alignment == CELLS_HUGE_PAGE_SIZE) {
+		madvise(memory, (size + alignment - 1) / alignment * alignment, MADV_HUGEPAGE);
+	}
+#endif
+	return memory;
+}
+
+
+// Out-of-core boards: with `--file`, the board lives in a file mapped in memory instead of being allocated,
+// so that it can be larger than the RAM. It's then stepped in bands of rows (see `step_cells`): the next band
+// is prefetched with `MADV_WILLNEED` while the current one is stepped, and the finished bands are written
+// back in order and dropped from the page cache, so that only a few bands are resident at once.
+//
+// The file starts with a page sized header, so that the cells are page aligned.
+
+#define BOARD_FILE_MAGIC		0x424c4f47 // "GOLB"
+#define BOARD_FILE_VERSION		1
+#define BOARD_FILE_HEADER_SIZE	4096
+#define BOARD_FILE_BAND_SIZE	(64 << 20)
+
+typedef struct {
+	uint32_t	magic;
+	uint32_t	version;
+	int64_t		width;
+	int64_t		height;
+	uint64_t	generation;
+	int32_t		mask;		// Bit of the cells that holds `generation`.
+	int32_t		reserved;
+} BoardFileHeader;
+
+typedef struct {
+	int					fd;
+	char *				map;
+	size_t				size;
+	BoardFileHeader *	header;
+	int64_t				band_rows;
+} BoardFile;
+
+static BoardFile board_file = { .fd = -1 };
+
+// Byte range of the file covering whole pages inside the rows `y_begin` to `y_end` (or the pages touching
+// them if `outward` is set). Returns false if it's empty.
+static bool
+board_file_range(int64_t y_begin, int64_t y_end, bool outward, size_t *begin, size_t *end)
+{
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	size_t first = BOARD_FILE_HEADER_SIZE + (size_t)y_begin * cell_count_w;
+	size_t last = BOARD_FILE_HEADER_SIZE + (size_t)y_end * cell_count_w;
+	*begin = outward ? first / page * page : (first + page - 1) / page * page;
+	*end = outward ? (last + page - 1) / page * page : last / page * page;
+	*end = *end > board_file.size ? board_file.size : *end;
+	return *begin < *end;
+}
+
+// Asks the kernel to start reading the rows `y_begin` to `y_end`.
+static void
+board_file_prefetch(int64_t y_begin, int64_t y_end)
+{
+	size_t begin, end;
+	if (board_file_range(y_begin, y_end, true, &begin, &end)) {
+		madvise(board_file.map + begin, end - begin, MADV_WILLNEED);
+	}
+}
+
+// Starts writing the rows `y_begin` to `y_end` back to the file. With `release`, also waits for it and drops
+// them from memory.
+static void
+board_file_writeback(int64_t y_begin, int64_t y_end, bool release)
+{
+	size_t begin, end;
+	if (board_file_range(y_begin, y_end, false, &begin, &end) == false) {
+		return;
+	}
+#ifdef __linux__
+	sync_file_range(board_file.fd, (off_t)begin, (off_t)(end - begin),
+					release ? SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER : SYNC_FILE_RANGE_WRITE);
+#else
+	msync(board_file.map + begin, end - begin, release ? MS_SYNC : MS_ASYNC);
+#endif
+	if (release) {
+		madvise(board_file.map + begin, end - begin, MADV_DONTNEED);
+		posix_fadvise(board_file.fd, (off_t)begin, (off_t)(end - begin), POSIX_FADV_DONTNEED);
+	}
+}
+
+static void
+board_file_close(void)
+{
+	if (board_file.map) {
+		msync(board_file.map, board_file.size, MS_SYNC);
+		munmap(board_file.map, board_file.size);
+		close(board_file.fd);
+		board_file = (BoardFile){ .fd = -1 };
+		cells = NULL;
+	}
+}
+
+
+// Change set: the kernels flag the tiles of 2^DIRTY_TILE_SHIFT x 2^DIRTY_TILE_SHIFT cells in which at least
+// one cell changed, with 2 flags: `DIRTY_REPAINT` so that the renderer only repaints those (it accumulates until
+// the renderer clears it), and `DIRTY_ACTIVE` so that the scheduler only steps the tiles around them next time
+// (it only holds the changes of the last step).
+
+#define DIRTY_TILE_SHIFT	4
+#define DIRTY_ROW(y)		(&dirty[((y) >> DIRTY_TILE_SHIFT) * dirty_w])
+#define DIRTY_REPAINT		1
+#define DIRTY_ACTIVE		2
+#define DIRTY_ALL			(DIRTY_REPAINT | DIRTY_ACTIVE)
+
+// Sizes the flags for the board, and flags all the tiles.
+static void
+init_dirty(void)
+{
+	int64_t w = (cell_count_w + (1 << DIRTY_TILE_SHIFT) - 1) >> DIRTY_TILE_SHIFT;
+	int64_t h = (cell_count_h + (1 << DIRTY_TILE_SHIFT) - 1) >> DIRTY_TILE_SHIFT;
+	if (dirty_w * dirty_h != w * h) {
+		free(dirty);
+		dirty = malloc((size_t)(w * h));
+	}
+	dirty_w = w;
+	dirty_h = h;
+	memset(dirty, DIRTY_ALL, (size_t)(w * h));
+}
+
+
+static void
+init_cells(char alive)
+{
+	size_t size = (size_t)cell_count_w * cell_count_h;
+	if (board_file.map == NULL) {
+		free(cells);
+		cells = alloc_cells(size);
+	}
+	init_dirty();
+
+	generation = 0;
+	srand(cell_seed ? cell_seed : (uint32_t)time(0));
+	for (int64_t y = 0; y != cell_count_h; ++y) {
+		for (char *cell = &cells[y * cell_count_w], *end = cell + cell_count_w; cell != end; ++cell) {
+			*cell = rand() < cell_prob ? alive : 0;
+		}
+
+		// An out-of-core board is written back as it's filled.
+		if (board_file.map && ((y + 1) % board_file.band_rows == 0 || y + 1 == cell_count_h)) {
+			board_file_writeback(y / board_file.band_rows * board_file.band_rows, y + 1, true);
+		}
+	}
+
+	if (board_file.map) {
+		board_file.header->generation = 0;
+		board_file.header->mask = (uint8_t)alive;
+	}
+}
+
+// Maps the board file at `path`. An existing board is loaded with its size and generation, otherwise a new
+// random board of `cell_count_w` x `cell_count_h` cells is created. Returns the mask of the current
+// generation, or 0 on error.
+static int
+board_file_open(const char *path)
+{
+	struct stat info;
+	bool create = stat(path, &info) != 0;
+	if (create && cell_count_w == 0) {
+		fprintf(stderr, "'%s' doesn't exist, the size of the board to create must be given with --size.\n", path);
+		return 0;
+	}
+
+	BoardFileHeader header = {
+		.magic = BOARD_FILE_MAGIC,
+		.version = BOARD_FILE_VERSION,
+		.width = cell_count_w,
+		.height = cell_count_h,
+		.mask = ALIVE_MASK_1,
+	};
+	int fd = open(path, O_RDWR | O_CREAT, 0644);
+	if (fd < 0) {
+		fprintf(stderr, "Couldn't open '%s'.\n", path);
+		return 0;
+	}
+	if (create) {
+		if (ftruncate(fd, (off_t)(BOARD_FILE_HEADER_SIZE + (size_t)cell_count_w * cell_count_h)) != 0) {
+			fprintf(stderr, "Couldn't create a %lldx%lld board in '%s'.\n", (long long)cell_count_w, (long long)cell_count_h, path);
+			close(fd);
+			return 0;
+		}
+	} else if (pread(fd, &header, sizeof(header), 0) != sizeof(header) || header.magic != BOARD_FILE_MAGIC ||
+			   header.version != BOARD_FILE_VERSION || header.width <= 0 || header.height <= 0 ||
+			   (header.mask != ALIVE_MASK_1 && header.mask != ALIVE_MASK_2) ||
+			   (size_t)info.st_size < BOARD_FILE_HEADER_SIZE + (size_t)header.width * header.height) {
+		fprintf(stderr, "'%s' is not a board.\n", path);
+		close(fd);
+		return 0;
+	}
+
+	size_t size = BOARD_FILE_HEADER_SIZE + (size_t)header.width * header.height;
+	char *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED) {
+		fprintf(stderr, "Couldn't map '%s'.\n", path);
+		close(fd);
+		return 0;
+	}
+	madvise(map, size, MADV_SEQUENTIAL);
+
+	free(cells);
+	cell_count_w = header.width;
+	cell_count_h = header.height;
+	cells = map + BOARD_FILE_HEADER_SIZE;
+	generation = header.generation;
+	init_dirty();
+
+	// Bands of about `BOARD_FILE_BAND_SIZE` bytes, in whole blocked tiles.
+	int64_t band_rows = BOARD_FILE_BAND_SIZE / cell_count_w / BLOCK_TILE_H * BLOCK_TILE_H;
+	board_file = (BoardFile){
+		.fd = fd,
+		.map = map,
+		.size = size,
+		.header = (BoardFileHeader *)map,
+		.band_rows = band_rows > BLOCK_TILE_H ? band_rows : BLOCK_TILE_H,
+	};
+
+	if (create) {
+		memcpy(map, &header, sizeof(header));
+		init_cells(ALIVE_MASK_1);
+	}
+	return board_file.header->mask;
+}
+
+
+// Formats the current rule (see `rule_format`). The result is valid until the next call.
+static const char *
+rule_to_string(void)
+{
+	static char text[64];
+	return rule_format(&rule, text, sizeof(text));
+}
+
+
+// Updates the tables derived from the current rule. Must be called whenever the rule changes.
+//
+// `rule_lut` maps a 4x4 neighborhood to the next state of its 2x2 center. The index is made of 4 columns
+// of 4 bits (bit `column * 4 + row`), and the result has the 2x2 center in bits 0 (row 1, column 1),
+// 1 (row 1, column 2), 2 (row 2, column 1) and 3 (row 2, column 2).
+//
+// `rule_sum_next` is the table of `rule_sum_table`, for the kernels of any radius.
+static void
+init_rule(void)
+{
+	++rule_serial;
+	rule_sum_table(&rule, rule_sum_next);
+
+	for (int n = 0; n != 9; ++n) {
+		rule_next[0][n] = (char)((rule.birth >> n) & 1);
+		rule_next[1][n] = (char)((rule.survive >> n) & 1);
+	}
+
+	for (int index = 0; index != 1 << 16; ++index) {
+		uint8_t result = 0;
+		for (int row = 1; row != 3; ++row) {
+			for (int column = 1; column != 3; ++column) {
+				int neighbors = 0;
+				for (int dy = -1; dy <= 1; ++dy) {
+					for (int dx = -1; dx <= 1; ++dx) {
+						if (dx != 0 || dy != 0) {
+							neighbors += (index >> ((column + dx) * 4 + row + dy)) & 1;
+						}
+					}
+				}
+				int alive = (index >> (column * 4 + row)) & 1;
+				result |= rule_next[alive][neighbors] << ((row - 1) * 2 + column - 1);
+			}
+		}
+		rule_lut[index] = result;
+	}
+}
+
+
+// Reference kernel: computes the next generation from the `mask` bit of each cell into its `next_mask` bit,
+// for the columns `x_begin` to `x_end` of the rows `y_begin` to `y_end`. Larger than Life rules simply sum
+// their whole neighborhood.
+static void
+update_cells(int mask, int next_mask, int64_t x_begin, int64_t x_end, int64_t y_begin, int64_t y_end)
+{
+	for (int64_t y = y_begin; rule.radius > 1 && y != y_end; ++y) {
+		uint8_t *dirty_row = DIRTY_ROW(y);
+		for (int64_t x = x_begin; x != x_end; ++x) {
+			int sum = 0;
+			for (int dy = -rule.radius; dy <= rule.radius; ++dy) {
+				for (int dx = -rule.radius; dx <= rule.radius; ++dx) {
+					sum += (CELL(x + dx, y + dy) & mask) ? 1 : 0;
+				}
+			}
+
+			char *cell = &CELL(x, y);
+			bool alive = (*cell & mask) != 0;
+			if (rule_sum_next[alive][sum]) {
+				*cell |= next_mask;
+			} else {
+				*cell &= ~next_mask;
+			}
+			if (alive != rule_sum_next[alive][sum]) {
+				dirty_row[x >> DIRTY_TILE_SHIFT] = DIRTY_ALL;
+			}
+		}
+	}
+	if (rule.radius > 1) {
+		return;
+	}
+
+	for (int64_t y = y_begin; y != y_end; ++y) {
+		uint8_t *dirty_row = DIRTY_ROW(y);
+		for (int64_t x = x_begin; x != x_end; ++x) {
+			int neighbors = ((CELL(x - 1, y - 1) & mask) ? 1 : 0) +
+							((CELL(x,     y - 1) & mask) ? 1 : 0) +
+							((CELL(x + 1, y - 1) & mask) ? 1 : 0) +
+							((CELL(x - 1, y    ) & mask) ? 1 : 0) +
+							((CELL(x + 1, y    ) & mask) ? 1 : 0) +
+							((CELL(x - 1, y + 1) & mask) ? 1 : 0) +
+							((CELL(x,     y + 1) & mask) ? 1 : 0) +
+							((CELL(x + 1, y + 1) & mask) ? 1 : 0);
+
+			char *cell = &CELL(x, y);
+			bool alive = (*cell & mask) != 0;
+			int counts = alive ? rule.survive : rule.birth;
+			if (counts & (1 << neighbors)) {
+				*cell |= next_mask;
+			} else {
+				*cell &= ~next_mask;
+			}
+			if (alive != ((counts >> neighbors) & 1)) {
+				dirty_row[x >> DIRTY_TILE_SHIFT] = DIRTY_ALL;
+			}
+		}
+	}
+}
+
+
+// Temporally blocked kernel: advances the board by `gens` generations, reading the `mask` bit of each cell
+// and writing the result in its `next_mask` bit, like `update_cells` does for a single generation.
+//
+// The board is split in cache sized tiles. Each tile is loaded in a scratch buffer with a halo of `gens`
+// cells on each side, and stepped `gens` times there. Since a cell depends on its 8 neighbors, the region
+// that is still valid shrinks by one cell on each side per generation (the trapezoid), so after `gens`
+// generations exactly the tile itself is valid and gets written back. The halos are recomputed by every
+// tile that needs them, but the board itself is only streamed through memory once per block instead of
+// once per generation.
+//
+// Tiles never write the `mask` bit, so all of them read the initial generation, whatever the processing order.
+static void
+update_cells_blocked(int mask, int next_mask, int gens, int64_t x_begin, int64_t x_end, int64_t y_begin, int64_t y_end)
+{
+	static _Thread_local char *scratch = NULL;
+	static _Thread_local int scratch_gens = 0;
+
+	int stride = BLOCK_TILE_W + 2 * gens;
+	int rows   = BLOCK_TILE_H + 2 * gens;
+	if (scratch_gens < gens) {
+		free(scratch);
+		scratch = malloc(2 * stride * rows);
+		scratch_gens = gens;
+	}
+
+	for (int64_t tile_y = y_begin; tile_y < y_end; tile_y += BLOCK_TILE_H) {
+		for (int64_t tile_x = x_begin; tile_x < x_end; tile_x += BLOCK_TILE_W) {
+			int tile_w = x_end - tile_x < BLOCK_TILE_W ? (int)(x_end - tile_x) : BLOCK_TILE_W;
+			int tile_h = y_end - tile_y < BLOCK_TILE_H ? (int)(y_end - tile_y) : BLOCK_TILE_H;
+			int w = tile_w + 2 * gens;
+			int h = tile_h + 2 * gens;
+			char *src = scratch;
+			char *dst = scratch + stride * rows;
+
+			// Load the tile and its halo, wrapping around the board edges.
+			for (int j = 0; j != h; ++j) {
+				char *row = &CELL(0, tile_y - gens + j);
+				int64_t x = mod(tile_x - gens, cell_count_w);
+				for (int i = 0; i != w; ++i) {
+					src[j * stride + i] = (row[x] & mask) ? 1 : 0;
+					if (++x == cell_count_w) {
+						x = 0;
+					}
+				}
+			}
+
+			// Step it, the valid region shrinking by one cell per generation.
+			for (int g = 1; g <= gens; ++g) {
+				for (int j = g; j != h - g; ++j) {
+					const char *up = src + (j - 1) * stride;
+					const char *mid = src + j * stride;
+					const char *down = src + (j + 1) * stride;
+					char *out = dst + j * stride;
+					for (int i = g; i != w - g; ++i) {
+						int neighbors = up[i - 1] + up[i] + up[i + 1] + mid[i - 1] + mid[i + 1] + down[i - 1] + down[i] + down[i + 1];
+						out[i] = rule_next[(int)mid[i]][neighbors];
+					}
+				}
+				char *swap = src;
+				src = dst;
+				dst = swap;
+			}
+
+			// Write the tile back, flagging the changes.
+			for (int j = 0; j != tile_h; ++j) {
+				char *row = &cells[(tile_y + j) * cell_count_w + tile_x];
+				const char *result = src + (gens + j) * stride + gens;
+				uint8_t *dirty_row = DIRTY_ROW(tile_y + j) + (tile_x >> DIRTY_TILE_SHIFT);
+				for (int i = 0; i != tile_w; ++i) {
+					dirty_row[i >> DIRTY_TILE_SHIFT] |= (uint8_t)((((row[i] & mask) ? 1 : 0) ^ result[i]) * DIRTY_ALL);
+					row[i] = result[i] ? row[i] | (char)next_mask : row[i] & ~(char)next_mask;
+				}
+			}
+		}
+	}
+}
+
+
+// Block lookup table kernel: computes the next generation 2x2 cells at a time, by packing their 4x4
+// neighborhood into a 16 bits index in `rule_lut`.
+//
+// For each pair of rows, the 4 bits columns of the 4 rows involved are gathered once, then each 2x2
+// block only needs 4 of those columns. When the board has an odd size, the last blocks overlap the first
+// row or column (wrapping around), and the cells that are outside of the board are simply not written.
+// `x_begin` must be even, so that the blocks are the same whatever the columns stepped.
+static void
+update_cells_lut(int mask, int next_mask, int64_t x_begin, int64_t x_end, int64_t y_begin, int64_t y_end)
+{
+	static _Thread_local uint8_t *columns = NULL;
+	static _Thread_local int64_t columns_size = 0;
+
+	if (columns_size < cell_count_w + 3) {
+		free(columns);
+		columns_size = cell_count_w + 3;
+		columns = malloc(columns_size);
+	}
+
+	for (int64_t y = y_begin; y < y_end; y += 2) {
+		const char *row0 = &CELL(0, y - 1);
+		char *row1 = &CELL(0, y);
+		char *row2 = &CELL(0, y + 1);
+		const char *row3 = &CELL(0, y + 2);
+
+		// columns[x + 1] is the column x, so that x - 1 and x + 2 are always valid. The 3 columns around the ones
+		// stepped wrap around the board.
+		uint8_t *column = columns + 1;
+		for (int64_t x = x_begin; x != x_end; ++x) {
+			column[x] = (uint8_t)(((row0[x] & mask) ? 1 : 0) |
+								  ((row1[x] & mask) ? 2 : 0) |
+								  ((row2[x] & mask) ? 4 : 0) |
+								  ((row3[x] & mask) ? 8 : 0));
+		}
+		for (int64_t x = x_begin - 1; x != x_end + 2; x = x == x_begin - 1 ? x_end : x + 1) {
+			int64_t c = mod(x, cell_count_w);
+			column[x] = (uint8_t)(((row0[c] & mask) ? 1 : 0) |
+								  ((row1[c] & mask) ? 2 : 0) |
+								  ((row2[c] & mask) ? 4 : 0) |
+								  ((row3[c] & mask) ? 8 : 0));
+		}
+
+		// The current state of the 2x2 block is bits 1 and 2 of its columns, in the layout of `rule_lut`'s results.
+		bool last_row = y + 1 == y_end;
+		uint8_t *dirty_row = DIRTY_ROW(y);
+		for (int64_t x = x_begin; x < x_end; x += 2) {
+			int result = rule_lut[column[x - 1] | column[x] << 4 | column[x + 1] << 8 | column[x + 2] << 12];
+			int current = (column[x] >> 1 & 1) | (column[x + 1] & 2) | (column[x] & 4) | (column[x + 1] << 1 & 8);
+			dirty_row[x >> DIRTY_TILE_SHIFT] |= (uint8_t)((result != current) * DIRTY_ALL);
+			row1[x] = (char)((row1[x] & ~next_mask) | ((result & 1) ? next_mask : 0));
+			if (last_row == false) {
+				row2[x] = (char)((row2[x] & ~next_mask) | ((result & 4) ? next_mask : 0));
+			}
+			if (x + 1 != cell_count_w) {
+				row1[x + 1] = (char)((row1[x + 1] & ~next_mask) | ((result & 2) ? next_mask : 0));
+				if (last_row == false) {
+					row2[x + 1] = (char)((row2[x + 1] & ~next_mask) | ((result & 8) ? next_mask : 0));
+				}
+			}
+		}
+	}
+}
+
+
+// Larger than Life kernel: computes the next generation like `update_cells` does, for rules of any radius R,
+// in constant time per cell. The kernel is in ltl.h, shared with the library (see gol.c).
+static void
+update_cells_ltl(int mask, int next_mask, int64_t x_begin, int64_t x_end, int64_t y_begin, int64_t y_end)
+{
+	static _Thread_local LtlScratch scratch = { 0 };
+
+	LtlBoard board = {
+		.cells = cells,
+		.width = cell_count_w,
+		.height = cell_count_h,
+		.radius = rule.radius,
+		.next = (const uint8_t (*)[LTL_MAX_COUNT + 1])rule_sum_next,
+		.dirty = dirty,
+		.dirty_w = dirty_w,
+		.dirty_shift = DIRTY_TILE_SHIFT,
+		.dirty_flags = DIRTY_ALL,
+	};
+	ltl_step(&board, &scratch, mask, next_mask, x_begin, x_end, y_begin, y_end);
+}
+
+
+// Performance counters: with `--counters` (or `C` in the game), every step is wrapped in Linux perf events
+// counting the cycles, instructions, L1 data / last level cache / data TLB misses and branch misses, in user
+// space. Perf events only count the thread that opened them, so each thread opens its own, and the workers of
+// the scheduler add their counts to the main thread's (see `counters_add`). Each event is opened on its own, so that the ones that can't be counted (virtual
+// machine, restrictive `perf_event_paranoid`, other OS, ...) are reported as not available instead of disabling
+// the others. When there are more events than hardware counters, the kernel multiplexes them, and the counts
+// are scaled by the fraction of the time they were actually counted.
+
+enum {
+	COUNTER_CYCLES,
+	COUNTER_INSTRUCTIONS,
+	COUNTER_L1_MISSES,
+	COUNTER_LLC_MISSES,
+	COUNTER_BRANCH_MISSES,
+	COUNTER_TLB_MISSES,
+	COUNTER_COUNT,
+};
+
+typedef struct {
+	const char *	name;
+	uint32_t		type;
+	uint64_t		config;
+} CounterEvent;
+
+#ifdef __linux__
+#	define COUNTER_CACHE_MISS(cache)	((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+static const CounterEvent counter_events[COUNTER_COUNT] = {
+	{ "cycles",			PERF_TYPE_HARDWARE,	PERF_COUNT_HW_CPU_CYCLES						},
+	{ "instructions",	PERF_TYPE_HARDWARE,	PERF_COUNT_HW_INSTRUCTIONS						},
+	{ "L1 misses",		PERF_TYPE_HW_CACHE,	COUNTER_CACHE_MISS(PERF_COUNT_HW_CACHE_L1D)		},
+	{ "LLC misses",		PERF_TYPE_HW_CACHE,	COUNTER_CACHE_MISS(PERF_COUNT_HW_CACHE_LL)		},
+	{ "branch misses",	PERF_TYPE_HARDWARE,	PERF_COUNT_HW_BRANCH_MISSES						},
+	{ "dTLB misses",	PERF_TYPE_HW_CACHE,	COUNTER_CACHE_MISS(PERF_COUNT_HW_CACHE_DTLB)	},
+};
+#else
+static const CounterEvent counter_events[COUNTER_COUNT] = {
+	{ "cycles" }, { "instructions" }, { "L1 misses" }, { "LLC misses" }, { "branch misses" }, { "dTLB misses" },
+};
+#endif
+
+// Counts of the events over `cells` stepped cells. A count is negative when the event isn't available.
+typedef struct {
+	double	values[COUNTER_COUNT];
+	double	cells;
+} Counters;
+
+static bool					counters_enabled				= false;
+static _Thread_local int	counter_fds[COUNTER_COUNT]		= { -2, -2, -2, -2, -2, -2 };
+static double				counter_begin[COUNTER_COUNT]	= { 0 };
+static double				counter_others[COUNTER_COUNT]	= { 0 };
+static Counters				counters_last					= { 0 };
+static Counters				counters_total					= { 0 };
+
+// Reads the (scaled) counts of the events of the calling thread, opening them on first use.
+static void
+counters_read(double values[COUNTER_COUNT])
+{
+	for (int i = 0; i != COUNTER_COUNT; ++i) {
+		values[i] = -1.0;
+#ifdef __linux__
+		if (counter_fds[i] == -2) {
+			struct perf_event_attr attr = {
+				.type = counter_events[i].type,
+				.size = sizeof(attr),
+				.config = counter_events[i].config,
+				.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING,
+				.exclude_kernel = 1,
+				.exclude_hv = 1,
+			};
+			counter_fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+		}
+		uint64_t data[3];
+		if (counter_fds[i] >= 0 && read(counter_fds[i], data, sizeof(data)) == sizeof(data) && data[2] != 0) {
+			values[i] = (double)data[0] * (double)data[1] / (double)data[2];
+		}
+#endif
+	}
+}
+
+static void
+counters_begin(void)
+{
+	if (counters_enabled) {
+		counters_read(counter_begin);
+		memset(counter_others, 0, sizeof(counter_others));
+	}
+}
+
+// Adds the counts `values` of another thread, for the current step.
+static void
+counters_add(const double values[COUNTER_COUNT])
+{
+	for (int i = 0; i != COUNTER_COUNT; ++i) {
+		counter_others[i] = counter_others[i] >= 0.0 && values[i] >= 0.0 ? counter_others[i] + values[i] : -1.0;
+	}
+}
+
+// Ends the counting started by `counters_begin`, `cells` having been stepped in between.
+static void
+counters_end(double cells)
+{
+	if (counters_enabled == false) {
+		return;
+	}
+
+	double end[COUNTER_COUNT];
+	counters_read(end);
+	for (int i = 0; i != COUNTER_COUNT; ++i) {
+		bool available = end[i] >= 0.0 && counter_begin[i] >= 0.0 && counter_others[i] >= 0.0;
+		counters_last.values[i] = available ? end[i] - counter_begin[i] + counter_others[i] : -1.0;
+		counters_total.values[i] = available && counters_total.values[i] >= 0.0 ? counters_total.values[i] + counters_last.values[i] : -1.0;
+	}
+	counters_last.cells = cells;
+	counters_total.cells += cells;
+}
+
+
+// Engines: the different kernels that can step the board. They all read the `mask` bit of each cell, write
+// the result in its `next_mask` bit for the columns `x_begin` to `x_end` of the rows `y_begin` to `y_end`, and
+// return the number of generations they advanced. Since the `mask` bit is never written, the board can be
+// stepped in any order, in several calls (on several threads). The ranges must start on an even row and
+// column, and an empty range steps nothing.
+
+typedef struct {
+	const char *	name;
+	int				(*step)(int mask, int next_mask, int64_t x_begin, int64_t x_end, int64_t y_begin, int64_t y_end);
+	int				max_radius;
+} Engine;
+
+static int
+step_reference(int mask, int next_mask, int64_t x_begin, int64_t x_end, int64_t y_begin, int64_t y_end)
+{
+	update_cells(mask, next_mask, x_begin, x_end, y_begin, y_end);
+	return 1;
+}
+
+static int
+step_blocked(int mask, int next_mask, int64_t x_begin, int64_t x_end, int64_t y_begin, int64_t y_end)
+{
+	update_cells_blocked(mask, next_mask, block_gens, x_begin, x_end, y_begin, y_end);
+	return block_gens;
+}
+
+static int
+step_lut(int mask, int next_mask, int64_t x_begin, int64_t x_end, int64_t y_begin, int64_t y_end)
+{
+	update_cells_lut(mask, next_mask, x_begin, x_end, y_begin, y_end);
+	return 1;
+}
+
+static int
+step_ltl(int mask, int next_mask, int64_t x_begin, int64_t x_end, int64_t y_begin, int64_t y_end)
+{
+	update_cells_ltl(mask, next_mask, x_begin, x_end, y_begin, y_end);
+	return 1;
+}
+
+// The largest radius of the rules each engine supports.
+static const Engine engines[] = {
+	{ "reference",	step_reference,	LTL_MAX_RADIUS	},
+	{ "blocked",	step_blocked,	1				},
+	{ "lut",		step_lut,		1				},
+	{ "ltl",		step_ltl,		LTL_MAX_RADIUS	},
+};
+
+#define ENGINE_COUNT ((int)(sizeof(engines) / sizeof(engines[0])))
+
+// Index of the engine called `name`, or -1.
+static int
+find_engine(const char *name)
+{
+	for (int e = 0; e != ENGINE_COUNT; ++e) {
+		if (strcmp(engines[e].name, name) == 0) {
+			return e;
+		}
+	}
+	return -1;
+}
+
+
+// Steps an out-of-core board band by band. A row is final once the band after it has been stepped, as the
+// kernels read up to `halo` rows around the ones they step, so the rows are written back one band behind, and
+// dropped one more band behind so that the writes overlap the next band. The first rows are kept until the
+// end, since the last band wraps around to them.
+static int
+step_board_file(int mask, int next_mask)
+{
+	int64_t reach = block_gens > rule.radius ? block_gens : rule.radius;
+	int64_t halo = reach + 2 < cell_count_h ? reach + 2 : cell_count_h;
+	int64_t written = halo;
+	int64_t released = halo;
+	int gens = 1;
+	for (int64_t y = 0; y < cell_count_h; y += board_file.band_rows) {
+		int64_t end = y + board_file.band_rows < cell_count_h ? y + board_file.band_rows : cell_count_h;
+		board_file_prefetch(end, end + board_file.band_rows + halo < cell_count_h ? end + board_file.band_rows + halo : cell_count_h);
+
+		gens = engines[engine].step(mask, next_mask, 0, cell_count_w, y, end);
+
+		int64_t done = end == cell_count_h ? cell_count_h : end - halo;
+		if (done > written) {
+			board_file_writeback(released, written, true);
+			board_file_writeback(written, done, false);
+			released = written;
+			written = done;
+		}
+	}
+	board_file_writeback(released, cell_count_h, true);
+	board_file_writeback(0, halo, true);
+
+	board_file.header->generation = generation + (uint64_t)gens;
+	board_file.header->mask = next_mask;
+	return gens;
+}
+
+// Packs the `mask` bit of the cells into `words` (see delta.h for the layout).
+//
+// 8 cells are loaded at once, their `mask` bit moved to the bottom of each byte, and the multiplication
+// gathers the 8 bits in the top byte (byte `i` to bit `i`, on a little endian machine).
+static void
+pack_cells(int mask, uint64_t *words)
+{
+	int shift = mask == ALIVE_MASK_1 ? 7 : 6;
+	size_t size = (size_t)cell_count_w * cell_count_h;
+	size_t i = 0;
+	for (; i + 64 <= size; i += 64) {
+		uint64_t word = 0;
+		for (int b = 0; b != 8; ++b) {
+			uint64_t bytes;
+			memcpy(&bytes, cells + i + b * 8, 8);
+			word |= (((bytes >> shift) & 0x0101010101010101ull) * 0x0102040810204080ull >> 56) << (b * 8);
+		}
+		words[i / 64] = word;
+	}
+	if (i != size) {
+		uint64_t word = 0;
+		for (size_t b = 0; b != size - i; ++b) {
+			word |= (uint64_t)((cells[i + b] & mask) ? 1 : 0) << b;
+		}
+		words[i / 64] = word;
+	}
+}
+
+
+static double
+get_time(void)
+{
+	struct timespec time;
+	timespec_get(&time, TIME_UTC);
+	return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+
+// Bounded single producer / single consumer queue of fixed size slots. The producer fills the slot returned
+// by `queue_push_begin` and publishes it with `queue_push_end`, the consumer reads the slot returned by
+// `queue_front` and releases it with `queue_pop`. Both return NULL when the queue is full / empty. Each index
+// is only written by one side, so neither side ever takes a lock.
+typedef struct {
+	uint8_t *			slots;
+	size_t				slot_size;
+	uint64_t			capacity;
+	_Atomic uint64_t	head;
+	_Atomic uint64_t	tail;
+} Queue;
+
+static void
+queue_init(Queue *queue, uint64_t capacity, size_t slot_size)
+{
+	queue->slots = malloc(capacity * slot_size);
+	queue->slot_size = slot_size;
+	queue->capacity = capacity;
+	atomic_init(&queue->head, 0);
+	atomic_init(&queue->tail, 0);
+}
+
+static void
+queue_free(Queue *queue)
+{
+	free(queue->slots);
+	queue->slots = NULL;
+}
+
+static uint64_t
+queue_count(Queue *queue)
+{
+	return atomic_load_explicit(&queue->head, memory_order_acquire) - atomic_load_explicit(&queue->tail, memory_order_acquire);
+}
+
+static void *
+queue_push_begin(Queue *queue)
+{
+	uint64_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+	if (head - atomic_load_explicit(&queue->tail, memory_order_acquire) == queue->capacity) {
+		return NULL;
+	}
+	return queue->slots + (head % queue->capacity) * queue->slot_size;
+}
+
+static void
+queue_push_end(Queue *queue)
+{
+	atomic_fetch_add_explicit(&queue->head, 1, memory_order_release);
+}
+
+static void *
+queue_front(Queue *queue)
+{
+	uint64_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+	if (atomic_load_explicit(&queue->head, memory_order_acquire) == tail) {
+		return NULL;
+	}
+	return queue->slots + (tail % queue->capacity) * queue->slot_size;
+}
+
+static void
+queue_pop(Queue *queue)
+{
+	atomic_fetch_add_explicit(&queue->tail, 1, memory_order_release);
+}
+
+
+// Work ranges: a range of indices packed in 64 bits (begin in the low half, end in the high one), so that an
+// owner taking indices from its front and thieves splitting it from the back agree with a single CAS.
+
+#define RANGE(begin, end)	(((uint64_t)(end) << 32) | (uint32_t)(begin))
+#define RANGE_BEGIN(range)	((uint32_t)(range))
+#define RANGE_END(range)	((uint32_t)((range) >> 32))
+
+// Takes up to `chunk` indices from the front of `range`, as [begin, end).
+static bool
+range_take(_Atomic uint64_t *range, uint32_t chunk, uint32_t *begin, uint32_t *end)
+{
+	uint64_t current = atomic_load(range);
+	while (RANGE_BEGIN(current) != RANGE_END(current)) {
+		uint32_t chunk_end = RANGE_END(current) - RANGE_BEGIN(current) > chunk ? RANGE_BEGIN(current) + chunk : RANGE_END(current);
+		if (atomic_compare_exchange_weak(range, &current, RANGE(chunk_end, RANGE_END(current)))) {
+			*begin = RANGE_BEGIN(current);
+			*end = chunk_end;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Steals the back half of the largest of `count` ranges, and makes it the range `own`. The ranges are fields of
+// an array of workers: the first one is `ranges`, and the next ones are every `stride` bytes after it.
+static bool
+range_steal(_Atomic uint64_t *own, _Atomic uint64_t *ranges, size_t stride, int count)
+{
+	for (;;) {
+		_Atomic uint64_t *victim = NULL;
+		uint64_t range = 0;
+		for (int i = 0; i != count; ++i) {
+			_Atomic uint64_t *other = (_Atomic uint64_t *)((char *)ranges + (size_t)i * stride);
+			uint64_t candidate = atomic_load(other);
+			if (RANGE_END(candidate) - RANGE_BEGIN(candidate) > RANGE_END(range) - RANGE_BEGIN(range)) {
+				victim = other;
+				range = candidate;
+			}
+		}
+		if (victim == NULL) {
+			return false;
+		}
+
+		uint32_t middle = RANGE_BEGIN(range) + (RANGE_END(range) - RANGE_BEGIN(range)) / 2;
+		if (atomic_compare_exchange_weak(victim, &range, RANGE(RANGE_BEGIN(range), middle))) {
+			atomic_store(own, RANGE(middle, RANGE_END(range)));
+			return true;
+		}
+	}
+}
+
+
+// Scheduler: the board is stepped in tiles of 2^SCHEDULER_TILE_SHIFT x 2^SCHEDULER_TILE_SHIFT cells, by the
+// main thread and `--threads <n>` - 1 workers. Only the active tiles are stepped: a cell can only change if a
+// cell within the kernel's reach changed in the previous step, so a tile without `DIRTY_ACTIVE` flags in it or
+// in the 8 tiles around it is skipped, both of its bits already holding its next generation. The tiles of the
+// last row and column also take the remaining cells, so that the tiles around one always cover the reach of
+// the kernels (up to `BLOCK_MAX_GENS` or `LTL_MAX_RADIUS` cells).
+//
+// The active tiles are listed in row order, and each thread gets those of its band of rows as a deque. It
+// steps the tiles from the front of its own deque, and when it's empty steals the back half of the largest
+// other one, so the threads keep the same regions while the activity is spread out, and share them when it
+// gathers in a few places.
+
+#define SCHEDULER_TILE_SHIFT	7
+
+typedef struct {
+	pthread_t			thread;
+	_Atomic uint64_t	range;
+	uint64_t			steals;
+	double				busy;
+	double				counters[COUNTER_COUNT];
+} SchedulerWorker;
+
+// Activity of the steps: the number of tiles and active tiles stepped, and the time the threads spent stepping
+// and idle, summed over all of them.
+typedef struct {
+	uint64_t	steps;
+	uint64_t	tiles;
+	uint64_t	active;
+	uint64_t	steals;
+	double		busy;
+	double		idle;
+} SchedulerStats;
+
+typedef struct {
+	SchedulerWorker *	workers;
+	int					worker_count;
+	uint32_t *			tasks;
+	uint8_t *			changed;
+	size_t				capacity;
+	int64_t				tiles_w;
+	int64_t				tiles_h;
+	int					mask;
+	int					next_mask;
+
+	// What the flags of the previous step were computed with: they don't tell anything about another engine or rule.
+	int					engine;
+	int					block_gens;
+	uint64_t			rule_serial;
+
+	pthread_mutex_t		lock;
+	pthread_cond_t		start;
+	uint64_t			step;
+	_Atomic int			pending;
+} Scheduler;
+
+static Scheduler		scheduler			= { .lock = PTHREAD_MUTEX_INITIALIZER, .start = PTHREAD_COND_INITIALIZER, .engine = -1 };
+static int				scheduler_threads	= 1;
+static SchedulerStats	scheduler_last		= { 0 };
+static SchedulerStats	scheduler_total		= { 0 };
+
+// First cell of the tile `tile`, and the first one after it, in a dimension of `count` cells split in `tiles` tiles.
+static int64_t
+scheduler_tile_begin(int64_t tile)
+{
+	return tile << SCHEDULER_TILE_SHIFT;
+}
+
+static int64_t
+scheduler_tile_end(int64_t tile, int64_t tiles, int64_t count)
+{
+	return tile + 1 == tiles ? count : (tile + 1) << SCHEDULER_TILE_SHIFT;
+}
+
+// Steps the tile `task`, after clearing its `DIRTY_ACTIVE` flags: the kernel sets them back where cells change.
+static void
+scheduler_run(uint32_t task)
+{
+	int64_t tile_x = task % scheduler.tiles_w;
+	int64_t tile_y = task / scheduler.tiles_w;
+	int64_t x0 = scheduler_tile_begin(tile_x);
+	int64_t x1 = scheduler_tile_end(tile_x, scheduler.tiles_w, cell_count_w);
+	int64_t y0 = scheduler_tile_begin(tile_y);
+	int64_t y1 = scheduler_tile_end(tile_y, scheduler.tiles_h, cell_count_h);
+
+	for (int64_t y = y0; y < y1; y += 1 << DIRTY_TILE_SHIFT) {
+		uint8_t *dirty_row = DIRTY_ROW(y);
+		for (int64_t x = x0 >> DIRTY_TILE_SHIFT; x != (x1 + (1 << DIRTY_TILE_SHIFT) - 1) >> DIRTY_TILE_SHIFT; ++x) {
+			dirty_row[x] &= (uint8_t)~DIRTY_ACTIVE;
+		}
+	}
+	engines[engine].step(scheduler.mask, scheduler.next_mask, x0, x1, y0, y1);
+}
+
+// Takes the tile at the front of the worker's own deque.
+static bool
+scheduler_take(SchedulerWorker *worker, uint32_t *task)
+{
+	uint32_t begin, end;
+	if (range_take(&worker->range, 1, &begin, &end) == false) {
+		return false;
+	}
+	*task = scheduler.tasks[begin];
+	return true;
+}
+
+// Steals the back half of the largest deque of the other workers, and makes it the worker's own deque.
+static bool
+scheduler_steal(SchedulerWorker *worker)
+{
+	if (range_steal(&worker->range, &scheduler.workers[0].range, sizeof(SchedulerWorker), scheduler.worker_count) == false) {
+		return false;
+	}
+	++worker->steals;
+	return true;
+}
+
+static void
+scheduler_work(SchedulerWorker *worker)
+{
+	uint32_t task;
+	while (scheduler_take(worker, &task) || (scheduler_steal(worker) && scheduler_take(worker, &task))) {
+		double begin = get_time();
+		scheduler_run(task);
+		worker->busy += get_time() - begin;
+	}
+}
+
+// The workers sleep between the steps, and live until the program exits.
+static void *
+scheduler_thread(void *data)
+{
+	SchedulerWorker *worker = data;
+	uint64_t step = 0;
+	for (;;) {
+		pthread_mutex_lock(&scheduler.lock);
+		while (scheduler.step == step) {
+			pthread_cond_wait(&scheduler.start, &scheduler.lock);
+		}
+		step = scheduler.step;
+		pthread_mutex_unlock(&scheduler.lock);
+
+		// Counted for the main thread, which counts its own part of the step.
+		double begin[COUNTER_COUNT], end[COUNTER_COUNT];
+		bool counted = counters_enabled;
+		if (counted) {
+			counters_read(begin);
+		}
+		scheduler_work(worker);
+		if (counted) {
+			counters_read(end);
+			for (int i = 0; i != COUNTER_COUNT; ++i) {
+				worker->counters[i] = end[i] >= 0.0 && begin[i] >= 0.0 ? end[i] - begin[i] : -1.0;
+			}
+		}
+		atomic_fetch_sub(&scheduler.pending, 1);
+	}
+	return NULL;
+}
+
+// Whether a cell of the tile, or of one of the 8 around it, changed in the previous step.
+static bool
+scheduler_active(int64_t tile_x, int64_t tile_y)
+{
+	for (int64_t y = tile_y - 1; y <= tile_y + 1; ++y) {
+		const uint8_t *changed = &scheduler.changed[mod(y, scheduler.tiles_h) * scheduler.tiles_w];
+		if (changed[mod(tile_x - 1, scheduler.tiles_w)] | changed[tile_x] | changed[mod(tile_x + 1, scheduler.tiles_w)]) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Steps the active tiles of the board from the `mask` bit to `next_mask` on all the threads, and returns the
+// number of generations advanced.
+static int
+scheduler_step(int mask, int next_mask)
+{
+	if (scheduler.workers == NULL) {
+		scheduler.worker_count = scheduler_threads;
+		scheduler.workers = calloc(scheduler.worker_count, sizeof(SchedulerWorker));
+		for (int i = 1; i != scheduler.worker_count; ++i) {
+			pthread_create(&scheduler.workers[i].thread, NULL, scheduler_thread, &scheduler.workers[i]);
+		}
+	}
+
+	int64_t tiles_w = cell_count_w >> SCHEDULER_TILE_SHIFT ? cell_count_w >> SCHEDULER_TILE_SHIFT : 1;
+	int64_t tiles_h = cell_count_h >> SCHEDULER_TILE_SHIFT ? cell_count_h >> SCHEDULER_TILE_SHIFT : 1;
+	size_t count = (size_t)(tiles_w * tiles_h);
+	if (scheduler.capacity < count) {
+		free(scheduler.tasks);
+		free(scheduler.changed);
+		scheduler.tasks = malloc(count * sizeof(uint32_t));
+		scheduler.changed = malloc(count);
+		scheduler.capacity = count;
+	}
+
+	bool all = scheduler.tiles_w != tiles_w || scheduler.tiles_h != tiles_h || scheduler.engine != engine ||
+			   scheduler.block_gens != block_gens || scheduler.rule_serial != rule_serial;
+	scheduler.tiles_w = tiles_w;
+	scheduler.tiles_h = tiles_h;
+	scheduler.engine = engine;
+	scheduler.block_gens = block_gens;
+	scheduler.rule_serial = rule_serial;
+	scheduler.mask = mask;
+	scheduler.next_mask = next_mask;
+
+	// Gather the changes of the previous step per tile, then list the active tiles band by band.
+	for (int64_t tile_y = 0; all == false && tile_y != tiles_h; ++tile_y) {
+		for (int64_t tile_x = 0; tile_x != tiles_w; ++tile_x) {
+			uint8_t changed = 0;
+			int64_t x_end = (scheduler_tile_end(tile_x, tiles_w, cell_count_w) + (1 << DIRTY_TILE_SHIFT) - 1) >> DIRTY_TILE_SHIFT;
+			int64_t y_end = scheduler_tile_end(tile_y, tiles_h, cell_count_h);
+			for (int64_t y = scheduler_tile_begin(tile_y); y < y_end; y += 1 << DIRTY_TILE_SHIFT) {
+				const uint8_t *dirty_row = DIRTY_ROW(y);
+				for (int64_t x = scheduler_tile_begin(tile_x) >> DIRTY_TILE_SHIFT; x != x_end; ++x) {
+					changed |= dirty_row[x];
+				}
+			}
+			scheduler.changed[tile_y * tiles_w + tile_x] = changed & DIRTY_ACTIVE;
+		}
+	}
+
+	uint32_t active = 0;
+	for (int i = 0; i != scheduler.worker_count; ++i) {
+		uint32_t begin = active;
+		for (int64_t tile_y = tiles_h * i / scheduler.worker_count; tile_y != tiles_h * (i + 1) / scheduler.worker_count; ++tile_y) {
+			for (int64_t tile_x = 0; tile_x != tiles_w; ++tile_x) {
+				if (all || scheduler_active(tile_x, tile_y)) {
+					scheduler.tasks[active++] = (uint32_t)(tile_y * tiles_w + tile_x);
+				}
+			}
+		}
+		atomic_store(&scheduler.workers[i].range, RANGE(begin, active));
+	}
+
+	// Step them, the main thread being the first worker.
+	double begin = get_time();
+	if (scheduler.worker_count > 1 && active != 0) {
+		atomic_store(&scheduler.pending, scheduler.worker_count - 1);
+		pthread_mutex_lock(&scheduler.lock);
+		++scheduler.step;
+		pthread_cond_broadcast(&scheduler.start);
+		pthread_mutex_unlock(&scheduler.lock);
+	}
+	scheduler_work(&scheduler.workers[0]);
+	while (atomic_load(&scheduler.pending) != 0) {
+		sched_yield();
+	}
+	double elapsed = get_time() - begin;
+
+	scheduler_last = (SchedulerStats){ .steps = 1, .tiles = count, .active = active };
+	for (int i = 1; counters_enabled && i != scheduler.worker_count; ++i) {
+		counters_add(scheduler.workers[i].counters);
+		memset(scheduler.workers[i].counters, 0, sizeof(scheduler.workers[i].counters));
+	}
+	for (int i = 0; i != scheduler.worker_count; ++i) {
+		scheduler_last.steals += scheduler.workers[i].steals;
+		scheduler_last.busy += scheduler.workers[i].busy;
+		scheduler.workers[i].steals = 0;
+		scheduler.workers[i].busy = 0.0;
+	}
+	scheduler_last.idle = active != 0 && elapsed * scheduler.worker_count > scheduler_last.busy ? elapsed * scheduler.worker_count - scheduler_last.busy : 0.0;
+	scheduler_total.steps += 1;
+	scheduler_total.tiles += scheduler_last.tiles;
+	scheduler_total.active += scheduler_last.active;
+	scheduler_total.steals += scheduler_last.steals;
+	scheduler_total.busy += scheduler_last.busy;
+	scheduler_total.idle += scheduler_last.idle;
+
+	// An empty range gives the number of generations of a step, even when no tile is active.
+	return engines[engine].step(mask, next_mask, 0, 0, 0, 0);
+}
+
+// Advances the board by one step of the current engine, from the `mask` bit to `next_mask`.
+static int
+step_cells(int mask, int next_mask)
+{
+	counters_begin();
+	int gens = board_file.map ? step_board_file(mask, next_mask) : scheduler_step(mask, next_mask);
+	counters_end((double)cell_count_w * cell_count_h * gens);
+	return gens;
+}
+
+
+// Recording: every step, the packed board is handed to a background writer thread, which delta compresses
+// it against the previous one and writes it to disk (see delta.h for the format). A keyframe is written
+// every `keyframe_interval` generations, and its offset appended to the index file.
+//
+// The simulation only packs the board, so it never waits on the disk unless the writer falls behind by
+// more than `RECORDER_QUEUE_SIZE` steps.
+
+#define RECORDER_QUEUE_SIZE			16
+#define RECORDER_KEYFRAME_INTERVAL	256
+
+// Header of the queue slots, followed by the packed board.
+typedef struct {
+	uint64_t	generation;
+	bool		keyframe;
+} RecorderSlot;
+
+typedef struct {
+	FILE *				file;
+	FILE *				index;
+	size_t				word_count;
+	uint64_t			keyframe_interval;
+	uint64_t			generation;
+	Queue				queue;
+	pthread_t			thread;
+	atomic_bool			stop;
+	_Atomic uint64_t	bytes_written;
+} Recorder;
+
+static Recorder	recorder			= { 0 };
+static bool		recording			= false;
+static uint64_t	keyframe_interval	= RECORDER_KEYFRAME_INTERVAL;
+
+static void *
+recorder_thread(void *data)
+{
+	(void)data;
+
+	uint64_t *previous = calloc(recorder.word_count, 8);
+	uint8_t *encoded = malloc(delta_encode_bound(recorder.word_count));
+	uint64_t offset = sizeof(DeltaFileHeader);
+	uint64_t next_keyframe = 0;
+
+	for (;;) {
+		// Checked before the queue, so that everything pushed before `stop` was set is still written.
+		bool stopping = atomic_load(&recorder.stop);
+		RecorderSlot *slot = queue_front(&recorder.queue);
+		if (slot == NULL) {
+			if (stopping) {
+				break;
+			}
+			sleep_ms(1);
+			continue;
+		}
+
+		const uint64_t *words = (const uint64_t *)(slot + 1);
+		bool keyframe = slot->keyframe || slot->generation >= next_keyframe;
+		if (keyframe) {
+			next_keyframe = slot->generation - slot->generation % recorder.keyframe_interval + recorder.keyframe_interval;
+			DeltaIndexEntry entry = { .generation = slot->generation, .offset = offset };
+			fwrite(&entry, sizeof(entry), 1, recorder.index);
+		}
+
+		DeltaRecord record = {
+			.generation = slot->generation,
+			.type = keyframe ? DELTA_RECORD_KEYFRAME : DELTA_RECORD_DELTA,
+			.size = (uint32_t)delta_encode(words, keyframe ? NULL : previous, recorder.word_count, encoded),
+		};
+		fwrite(&record, sizeof(record), 1, recorder.file);
+		fwrite(encoded, 1, record.size, recorder.file);
+		offset += sizeof(record) + record.size;
+		atomic_store(&recorder.bytes_written, offset);
+
+		memcpy(previous, words, recorder.word_count * 8);
+		queue_pop(&recorder.queue);
+	}
+
+	free(previous);
+	free(encoded);
+	return NULL;
+}
+
+static bool
+recording_start(const char *path)
+{
+	recorder.file = fopen(path, "wb");
+	recorder.index = fopen(TextFormat("%s.idx", path), "wb");
+	if (recorder.file == NULL || recorder.index == NULL) {
+		fprintf(stderr, "Couldn't open '%s' for recording.\n", path);
+		if (recorder.file) {
+			fclose(recorder.file);
+		}
+		if (recorder.index) {
+			fclose(recorder.index);
+		}
+		return false;
+	}
+	setvbuf(recorder.file, NULL, _IOFBF, 1 << 20);
+
+	DeltaFileHeader header = {
+		.magic = DELTA_MAGIC,
+		.version = DELTA_VERSION,
+		.width = (uint32_t)cell_count_w,
+		.height = (uint32_t)cell_count_h,
+		.keyframe_interval = (uint32_t)keyframe_interval,
+	};
+	fwrite(&header, sizeof(header), 1, recorder.file);
+
+	recorder.word_count = delta_word_count(cell_count_w, cell_count_h);
+	recorder.keyframe_interval = keyframe_interval;
+	recorder.generation = 0;
+	atomic_init(&recorder.stop, false);
+	atomic_init(&recorder.bytes_written, sizeof(header));
+	queue_init(&recorder.queue, RECORDER_QUEUE_SIZE, sizeof(RecorderSlot) + recorder.word_count * 8);
+	pthread_create(&recorder.thread, NULL, recorder_thread, NULL);
+	recording = true;
+	return true;
+}
+
+// Records the packed board after a step of `gens` generations (0 for a new board).
+static void
+recording_push(const uint64_t *words, int gens)
+{
+	if (recording == false) {
+		return;
+	}
+
+	RecorderSlot *slot;
+	while ((slot = queue_push_begin(&recorder.queue)) == NULL) {
+		sleep_ms(1);
+	}
+
+	recorder.generation += gens;
+	slot->generation = recorder.generation;
+	slot->keyframe = gens == 0;
+	memcpy(slot + 1, words, recorder.word_count * 8);
+	queue_push_end(&recorder.queue);
+}
+
+static void
+recording_stop(void)
+{
+	if (recording == false) {
+		return;
+	}
+
+	atomic_store(&recorder.stop, true);
+	pthread_join(recorder.thread, NULL);
+	queue_free(&recorder.queue);
+	fclose(recorder.file);
+	fclose(recorder.index);
+	recording = false;
+}
+
+
+// Rewind buffer: the last generations are kept in memory as XOR deltas (see delta.h), so that the board can
+// be stepped backwards by applying them to the current generation, and forward again by re-applying them.
+// A full snapshot is also stored every `REWIND_SNAPSHOT_INTERVAL` entries, so that jumping far away doesn't
+// require walking through all the deltas in between.
+//
+// The memory is capped by `rewind_budget`: 1/8th of it holds the entries descriptors and the rest is a ring
+// of encoded data. When either is full, the oldest entries are dropped.
+//
+// Entry `i` leads from the state `i` to the state `i + 1`, state 0 being the oldest one still available, and
+// `cursor` is the state the board is currently in. When rewound, stepping the simulation again discards the
+// entries after the cursor.
+
+#define REWIND_DEFAULT_BUDGET		(64ull << 20)
+#define REWIND_SNAPSHOT_INTERVAL	64
+
+typedef struct {
+	uint64_t	offset;
+	uint64_t	generation;
+	uint32_t	delta_size;
+	uint32_t	snapshot_size;
+} RewindEntry;
+
+typedef struct {
+	uint8_t *		data;
+	uint64_t		data_size;
+	uint64_t		data_begin;
+	uint64_t		data_end;
+	RewindEntry *	entries;
+	uint64_t		entry_capacity;
+	uint64_t		first;
+	uint64_t		count;
+	uint64_t		cursor;
+	uint64_t		base_generation;
+	uint64_t		since_snapshot;
+	size_t			word_count;
+	uint64_t *		current;
+	uint8_t *		encoded;
+} Rewind;
+
+static Rewind	rewind_buffer	= { 0 };
+static uint64_t	rewind_budget	= REWIND_DEFAULT_BUDGET;
+
+#define REWIND_ENTRY(i) (rewind_buffer.entries[(rewind_buffer.first + (i)) % rewind_buffer.entry_capacity])
+
+static void
+rewind_free(void)
+{
+	free(rewind_buffer.data);
+	free(rewind_buffer.entries);
+	free(rewind_buffer.current);
+	free(rewind_buffer.encoded);
+	memset(&rewind_buffer, 0, sizeof(rewind_buffer));
+}
+
+// (Re)starts the history from the packed board `words`, of generation `generation`.
+static void
+rewind_init(const uint64_t *words, uint64_t generation)
+{
+	rewind_free();
+	if (rewind_budget == 0) {
+		return;
+	}
+
+	Rewind *r = &rewind_buffer;
+	r->entry_capacity = rewind_budget / 8 / sizeof(RewindEntry);
+	r->entries = malloc(r->entry_capacity * sizeof(RewindEntry));
+	r->data_size = rewind_budget - r->entry_capacity * sizeof(RewindEntry);
+	r->data = malloc(r->data_size);
+	r->word_count = delta_word_count(cell_count_w, cell_count_h);
+	r->current = malloc(r->word_count * 8);
+	r->encoded = malloc(2 * delta_encode_bound(r->word_count));
+	r->base_generation = generation;
+	memcpy(r->current, words, r->word_count * 8);
+}
+
+// Copies between `buffer` and the data ring at `offset`, wrapping around its end.
+static void
+rewind_copy(uint64_t offset, void *buffer, size_t size, bool write)
+{
+	uint64_t position = offset % rewind_buffer.data_size;
+	size_t first = rewind_buffer.data_size - position < size ? (size_t)(rewind_buffer.data_size - position) : size;
+	uint8_t *ring = rewind_buffer.data;
+	if (write) {
+		memcpy(ring + position, buffer, first);
+		memcpy(ring, (uint8_t *)buffer + first, size - first);
+	} else {
+		memcpy(buffer, ring + position, first);
+		memcpy((uint8_t *)buffer + first, ring, size - first);
+	}
+}
+
+static void
+rewind_drop_oldest(void)
+{
+	Rewind *r = &rewind_buffer;
+	r->base_generation = REWIND_ENTRY(0).generation;
+	r->first = (r->first + 1) % r->entry_capacity;
+	r->data_begin = --r->count ? REWIND_ENTRY(0).offset : r->data_end;
+	--r->cursor;
+}
+
+// Adds the step that led to the packed board `words`, of generation `generation`.
+static void
+rewind_push(const uint64_t *words, uint64_t generation)
+{
+	Rewind *r = &rewind_buffer;
+	if (r->data == NULL) {
+		return;
+	}
+
+	// Stepping from a rewound state forks the history.
+	if (r->cursor != r->count) {
+		r->data_end = REWIND_ENTRY(r->cursor).offset;
+		r->count = r->cursor;
+		r->since_snapshot = REWIND_SNAPSHOT_INTERVAL;
+	}
+
+	uint32_t delta_size = (uint32_t)delta_encode(words, r->current, r->word_count, r->encoded);
+	uint32_t snapshot_size = 0;
+	if (++r->since_snapshot >= REWIND_SNAPSHOT_INTERVAL) {
+		snapshot_size = (uint32_t)delta_encode(words, NULL, r->word_count, r->encoded + delta_size);
+		r->since_snapshot = 0;
+	}
+	memcpy(r->current, words, r->word_count * 8);
+
+	uint64_t size = (uint64_t)delta_size + snapshot_size;
+	if (size > r->data_size) {
+		rewind_init(words, generation);
+		return;
+	}
+	while (r->count == r->entry_capacity || r->data_end - r->data_begin + size > r->data_size) {
+		rewind_drop_oldest();
+	}
+
+	REWIND_ENTRY(r->count) = (RewindEntry){
+		.offset = r->data_end,
+		.generation = generation,
+		.delta_size = delta_size,
+		.snapshot_size = snapshot_size,
+	};
+	rewind_copy(r->data_end, r->encoded, size, true);
+	r->data_end += size;
+	r->cursor = ++r->count;
+}
+
+// Moves the rewind buffer to `state`, using the nearest snapshot when it's closer than the cursor, and
+// returns the generation of that state. The packed board is then in `rewind_buffer.current`.
+static uint64_t
+rewind_seek(uint64_t state)
+{
+	Rewind *r = &rewind_buffer;
+	if (state > r->count) {
+		state = r->count;
+	}
+
+	// Nearest snapshot (the state after the entry that holds it).
+	uint64_t distance = state > r->cursor ? state - r->cursor : r->cursor - state;
+	for (uint64_t i = 0; i != r->count; ++i) {
+		uint64_t snapshot_state = i + 1;
+		uint64_t snapshot_distance = state > snapshot_state ? state - snapshot_state : snapshot_state - state;
+		if (REWIND_ENTRY(i).snapshot_size && snapshot_distance < distance) {
+			RewindEntry *entry = &REWIND_ENTRY(i);
+			rewind_copy(entry->offset + entry->delta_size, r->encoded, entry->snapshot_size, false);
+			memset(r->current, 0, r->word_count * 8);
+			delta_apply(r->encoded, entry->snapshot_size, r->current, r->word_count);
+			r->cursor = snapshot_state;
+			distance = snapshot_distance;
+		}
+	}
+
+	// Walk the deltas.
+	while (r->cursor != state) {
+		RewindEntry *entry = &REWIND_ENTRY(r->cursor > state ? r->cursor - 1 : r->cursor);
+		rewind_copy(entry->offset, r->encoded, entry->delta_size, false);
+		delta_apply(r->encoded, entry->delta_size, r->current, r->word_count);
+		r->cursor += r->cursor > state ? -1 : 1;
+	}
+
+	return r->cursor ? REWIND_ENTRY(r->cursor - 1).generation : r->base_generation;
+}
+
+
+// Shared memory export: with `--shm <name>`, every generation is published in a POSIX shared memory segment
+// for other processes to read (see shm_board.h). The board is packed directly in the segment, and the rewind
+// buffer and the recorder then use it from there, so the export doesn't cost a copy.
+
+static const char *		shm_name		= NULL;
+static ShmBoardHeader *	shm				= NULL;
+static size_t			shm_size		= 0;
+
+// Marks the segment as closed for its readers, and removes it.
+static void
+shm_close(void)
+{
+	if (shm) {
+		atomic_store_explicit(&shm->closed, 1, memory_order_release);
+		munmap(shm, shm_size);
+		shm_unlink(shm_name);
+		shm = NULL;
+	}
+}
+
+// (Re)creates the segment for the current size of the board. Returns false on error.
+static bool
+shm_create(void)
+{
+	shm_close();
+
+	size_t count = delta_word_count(cell_count_w, cell_count_h);
+	size_t size = shm_board_size(count);
+	shm_unlink(shm_name);
+	int fd = shm_open(shm_name, O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (fd < 0 || ftruncate(fd, (off_t)size) != 0) {
+		fprintf(stderr, "Couldn't create the shared memory segment '%s'.\n", shm_name);
+		if (fd >= 0) {
+			close(fd);
+			shm_unlink(shm_name);
+		}
+		return false;
+	}
+	void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		fprintf(stderr, "Couldn't map the shared memory segment '%s'.\n", shm_name);
+		shm_unlink(shm_name);
+		return false;
+	}
+
+	// The magic is only written with the first board, see `shm_write_end`.
+	shm = map;
+	shm_size = size;
+	shm->version = SHM_BOARD_VERSION;
+	shm->width = (uint64_t)cell_count_w;
+	shm->height = (uint64_t)cell_count_h;
+	shm->word_count = count;
+	return true;
+}
+
+// Starts writing the next board in the segment, in the buffer that's not the latest one. Returns its words.
+static uint64_t *
+shm_write_begin(void)
+{
+	uint32_t index = 1 - atomic_load_explicit(&shm->latest, memory_order_relaxed);
+	ShmBoardBuffer *buffer = &shm->buffers[index];
+	atomic_store_explicit(&buffer->sequence, atomic_load_explicit(&buffer->sequence, memory_order_relaxed) + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	return shm_board_words(shm, index);
+}
+
+// Publishes the board started by `shm_write_begin`.
+static void
+shm_write_end(void)
+{
+	uint32_t index = 1 - atomic_load_explicit(&shm->latest, memory_order_relaxed);
+	ShmBoardBuffer *buffer = &shm->buffers[index];
+	const uint64_t *words = shm_board_words(shm, index);
+	uint64_t population = 0;
+	for (size_t i = 0; i != shm->word_count; ++i) {
+		population += delta_popcount(words[i]);
+	}
+	buffer->generation = generation;
+	buffer->population = population;
+	atomic_store_explicit(&buffer->sequence, atomic_load_explicit(&buffer->sequence, memory_order_relaxed) + 1, memory_order_release);
+	atomic_store_explicit(&shm->latest, index, memory_order_release);
+	if (shm->magic == 0) {
+		atomic_thread_fence(memory_order_release);
+		shm->magic = SHM_BOARD_MAGIC;
+	}
+}
+
+
+// Streaming server: with `--serve <path>`, every generation is handed to a server thread (through a queue,
+// like the recorder does), which streams it to the clients connected to a Unix domain socket (see stream.h).
+//
+// Each client has a bounded send buffer, written to its socket without blocking. When a client falls so far
+// behind that its buffer can't hold the next delta, the messages it didn't start to receive are dropped, and
+// it gets a keyframe of the current board instead. When the server itself falls behind, the simulation skips
+// generations instead of waiting (the next delta then covers them), so nothing can stall the simulation.
+
+#define SERVER_QUEUE_SIZE		4
+#define SERVER_MAX_CLIENTS		64
+#define SERVER_CLIENT_BUFFER	(4 << 20)
+
+// Header of the queue slots, followed by the packed board.
+typedef struct {
+	uint64_t	generation;
+} ServerSlot;
+
+typedef struct {
+	int			socket;
+	bool		keyframe;		// The next message must be a keyframe.
+	uint8_t *	buffer;
+	size_t		capacity;
+	size_t		begin;			// Sent up to there.
+	size_t		message;		// Start of the message being sent.
+	size_t		end;
+} ServerClient;
+
+typedef struct {
+	const char *	path;
+	int				socket;
+	bool			running;
+	int64_t			width;
+	int64_t			height;
+	size_t			word_count;
+	ServerClient	clients[SERVER_MAX_CLIENTS];
+	int				client_count;
+	Queue			queue;
+	pthread_t		thread;
+	atomic_bool		stop;
+} Server;
+
+static Server server = { .socket = -1 };
+
+// Appends a message to the buffer of `client`. Returns false if it doesn't fit.
+static bool
+server_append(ServerClient *client, const StreamMessage *message, const uint8_t *payload)
+{
+	size_t size = sizeof(*message) + message->size;
+	if (client->end + size > client->capacity && client->message != 0) {
+		memmove(client->buffer, client->buffer + client->message, client->end - client->message);
+		client->begin -= client->message;
+		client->end -= client->message;
+		client->message = 0;
+	}
+	if (client->end + size > client->capacity) {
+		return false;
+	}
+	memcpy(client->buffer + client->end, message, sizeof(*message));
+	memcpy(client->buffer + client->end + sizeof(*message), payload, message->size);
+	client->end += size;
+	return true;
+}
+
+// Drops the messages that `client` didn't start to receive, so that it gets a keyframe next.
+static void
+server_drop(ServerClient *client)
+{
+	client->end = client->message;
+	if (client->begin != client->message) {
+		StreamMessage message;
+		memcpy(&message, client->buffer + client->message, sizeof(message));
+		client->end += sizeof(message) + message.size;
+	}
+	client->keyframe = true;
+}
+
+// Sends as much of the buffer of `client` as its socket takes without blocking. Returns false when the client
+// is gone.
+static bool
+server_send(ServerClient *client)
+{
+	while (client->begin != client->end) {
+		ssize_t sent = send(client->socket, client->buffer + client->begin, client->end - client->begin, 0);
+		if (sent < 0) {
+			return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+		}
+		client->begin += (size_t)sent;
+
+		// Skip the messages that are completely sent.
+		while (client->message != client->begin) {
+			StreamMessage message;
+			memcpy(&message, client->buffer + client->message, sizeof(message));
+			if (client->message + sizeof(message) + message.size > client->begin) {
+				break;
+			}
+			client->message += sizeof(message) + message.size;
+		}
+	}
+	client->begin = client->message = client->end = 0;
+	return true;
+}
+
+static void *
+server_thread(void *data)
+{
+	(void)data;
+
+	size_t count = server.word_count;
+	uint64_t *current = calloc(count, 8);
+	uint8_t *delta = malloc(delta_encode_bound(count));
+	uint8_t *keyframe = malloc(delta_encode_bound(count));
+	StreamMessage message = {
+		.magic = STREAM_MAGIC,
+		.width = (uint32_t)server.width,
+		.height = (uint32_t)server.height,
+	};
+	bool has_board = false;
+
+	while (atomic_load(&server.stop) == false) {
+		int client;
+		while ((client = accept(server.socket, NULL, NULL)) >= 0) {
+			// Left in the backlog, the client would wait forever: it's closed before any message instead.
+			if (server.client_count == SERVER_MAX_CLIENTS) {
+				fprintf(stderr, "Streaming server: %d clients already connected, connection refused.\n", SERVER_MAX_CLIENTS);
+				close(client);
+				continue;
+			}
+			fcntl(client, F_SETFL, fcntl(client, F_GETFL) | O_NONBLOCK);
+			size_t capacity = 2 * (sizeof(StreamMessage) + delta_encode_bound(count));
+			capacity = capacity > SERVER_CLIENT_BUFFER ? capacity : SERVER_CLIENT_BUFFER;
+			server.clients[server.client_count++] = (ServerClient){
+				.socket = client,
+				.keyframe = true,
+				.buffer = malloc(capacity),
+				.capacity = capacity,
+			};
+		}
+
+		// Deltas of the new boards.
+		size_t keyframe_size = 0;
+		ServerSlot *slot;
+		while ((slot = queue_front(&server.queue)) != NULL) {
+			const uint64_t *words = (const uint64_t *)(slot + 1);
+			message.type = STREAM_DELTA;
+			message.generation = slot->generation;
+			message.size = delta_encode(words, current, count, delta);
+			message.population = 0;
+			for (size_t i = 0; i != count; ++i) {
+				message.population += delta_popcount(words[i]);
+			}
+			message.hash = stream_hash(words, count);
+			for (int i = 0; has_board && i != server.client_count; ++i) {
+				if (server.clients[i].keyframe == false && server_append(&server.clients[i], &message, delta) == false) {
+					server_drop(&server.clients[i]);
+				}
+			}
+			memcpy(current, words, count * 8);
+			has_board = true;
+			keyframe_size = 0;
+			queue_pop(&server.queue);
+		}
+
+		// Keyframes of the current board, for the new clients and the ones that fell behind.
+		for (int i = 0; has_board && i != server.client_count; ++i) {
+			if (server.clients[i].keyframe) {
+				if (keyframe_size == 0) {
+					keyframe_size = delta_encode(current, NULL, count, keyframe);
+				}
+				StreamMessage header = message;
+				header.type = STREAM_KEYFRAME;
+				header.size = keyframe_size;
+				server.clients[i].keyframe = server_append(&server.clients[i], &header, keyframe) == false;
+			}
+		}
+
+		// Send, and wait until a socket is ready or for the next board.
+		struct pollfd fds[SERVER_MAX_CLIENTS + 1] = { { .fd = server.socket, .events = POLLIN } };
+		for (int i = 0; i != server.client_count; ++i) {
+			if (server_send(&server.clients[i]) == false) {
+				close(server.clients[i].socket);
+				free(server.clients[i].buffer);
+				server.clients[i--] = server.clients[--server.client_count];
+				continue;
+			}
+			fds[i + 1] = (struct pollfd){ .fd = server.clients[i].socket, .events = server.clients[i].end ? POLLOUT : 0 };
+		}
+		poll(fds, (nfds_t)server.client_count + 1, 1);
+	}
+
+	free(current);
+	free(delta);
+	free(keyframe);
+	return NULL;
+}
+
+// Starts the server thread for the current size of the board. The clients get a keyframe of its first board.
+static void
+server_thread_start(void)
+{
+	server.width = cell_count_w;
+	server.height = cell_count_h;
+	server.word_count = delta_word_count(cell_count_w, cell_count_h);
+	for (int i = 0; i != server.client_count; ++i) {
+		server.clients[i].keyframe = true;
+	}
+	atomic_init(&server.stop, false);
+	queue_init(&server.queue, SERVER_QUEUE_SIZE, sizeof(ServerSlot) + server.word_count * 8);
+	pthread_create(&server.thread, NULL, server_thread, NULL);
+}
+
+static void
+server_thread_stop(void)
+{
+	atomic_store(&server.stop, true);
+	pthread_join(server.thread, NULL);
+	queue_free(&server.queue);
+}
+
+static bool
+server_start(const char *path)
+{
+	struct sockaddr_un address = { .sun_family = AF_UNIX };
+	if (strlen(path) >= sizeof(address.sun_path)) {
+		fprintf(stderr, "The socket path '%s' is too long.\n", path);
+		return false;
+	}
+	strcpy(address.sun_path, path);
+
+	unlink(path);
+	server.socket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (server.socket < 0 || bind(server.socket, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(server.socket, 16) != 0) {
+		fprintf(stderr, "Couldn't listen on '%s'.\n", path);
+		if (server.socket >= 0) {
+			close(server.socket);
+			server.socket = -1;
+		}
+		return false;
+	}
+	fcntl(server.socket, F_SETFL, fcntl(server.socket, F_GETFL) | O_NONBLOCK);
+
+	// Writing to a client that's gone must fail instead of killing the game.
+	signal(SIGPIPE, SIG_IGN);
+
+	server.path = path;
+	server.running = true;
+	server_thread_start();
+	return true;
+}
+
+// Hands the packed board to the server thread. If the server is still busy with the previous ones, the
+// board is skipped.
+static void
+server_push(const uint64_t *words)
+{
+	if (server.running == false) {
+		return;
+	}
+	if (server.width != cell_count_w || server.height != cell_count_h) {
+		server_thread_stop();
+		server_thread_start();
+	}
+
+	ServerSlot *slot = queue_push_begin(&server.queue);
+	if (slot) {
+		slot->generation = generation;
+		memcpy(slot + 1, words, server.word_count * 8);
+		queue_push_end(&server.queue);
+	}
+}
+
+static void
+server_stop(void)
+{
+	if (server.running == false) {
+		return;
+	}
+
+	server_thread_stop();
+	for (int i = 0; i != server.client_count; ++i) {
+		close(server.clients[i].socket);
+		free(server.clients[i].buffer);
+	}
+	server.client_count = 0;
+	close(server.socket);
+	unlink(server.path);
+	server.running = false;
+}
+
+
+// Packed copy of the current board, shared by the rewind buffer and the recorder, when it's not exported.
+static uint64_t *	packed			= NULL;
+static size_t		packed_count	= 0;
+
+// Called after every step of `gens` generations, or with `gens` 0 when the board was reset.
+static void
+publish_step(int mask, int gens)
+{
+	if (recording == false && rewind_budget == 0 && shm_name == NULL && server.running == false) {
+		return;
+	}
+
+	size_t count = delta_word_count(cell_count_w, cell_count_h);
+	if (shm_name && (shm == NULL || shm->width != (uint64_t)cell_count_w || shm->height != (uint64_t)cell_count_h) && shm_create() == false) {
+		shm_name = NULL;
+	}
+
+	uint64_t *words = packed;
+	if (shm) {
+		words = shm_write_begin();
+	} else if (packed_count != count) {
+		free(packed);
+		packed = words = malloc(count * 8);
+		packed_count = count;
+	}
+	pack_cells(mask, words);
+	if (shm) {
+		shm_write_end();
+	}
+	server_push(words);
+
+	if (recording == false && rewind_budget == 0) {
+		return;
+	}
+	if (gens == 0 || rewind_buffer.word_count != count) {
+		rewind_init(words, generation);
+	} else {
+		rewind_push(words, generation);
+	}
+	recording_push(words, gens);
+}
+
+// Writes the packed board `words` in the `mask` bit of the cells.
+static void
+unpack_cells(int mask, const uint64_t *words)
+{
+	for (size_t i = 0, size = (size_t)cell_count_w * cell_count_h; i != size; ++i) {
+		cells[i] = (words[i / 64] >> (i % 64)) & 1 ? cells[i] | (char)mask : cells[i] & ~(char)mask;
+	}
+	init_dirty();
+}
+
+// Moves the board to the rewind buffer's `state`. A recording can't jump back in time (the player indexes it by
+// generation), so it stops, as it does when the board is resized.
+static void
+rewind_to(int mask, uint64_t state)
+{
+	generation = rewind_seek(state);
+	unpack_cells(mask, rewind_buffer.current);
+	if (shm) {
+		memcpy(shm_write_begin(), rewind_buffer.current, shm->word_count * 8);
+		shm_write_end();
+	}
+	server_push(rewind_buffer.current);
+	if (recording) {
+		printf("Rewound to generation %llu, recording stopped.\n", (unsigned long long)generation);
+		recording_stop();
+	}
+}
+
+// Replaces the board with a new random one. A recording can't hold 2 boards at the same generation (the player
+// indexes it by generation), so it stops, as it does when the board is rewound.
+static void
+reset_board(int mask)
+{
+	if (recording) {
+		printf("Board reset, recording stopped.\n");
+		recording_stop();
+	}
+	init_cells((char)mask);
+	publish_step(mask, 0);
+}
+
+
+// FNV-1a hash of the live cells, used to compare the results of the different kernels.
+static uint64_t
+hash_cells(int mask)
+{
+	uint64_t hash = DELTA_HASH_BASIS;
+	for (size_t i = 0, size = (size_t)cell_count_w * cell_count_h; i != size; ++i) {
+		hash = delta_hash_cell(hash, (cells[i] & mask) ? 1 : 0);
+	}
+	return hash;
+}
+
+
+// Memory stats: the resident set size and the part of it backed by transparent huge pages, from /proc. Each
+// of them is -1 when it's not available.
+
+typedef struct {
+	int64_t		rss;
+	int64_t		huge_pages;
+} MemoryStats;
+
+static MemoryStats
+read_memory_stats(void)
+{
+	MemoryStats stats = { -1, -1 };
+
+	long long pages;
+	FILE *file = fopen("/proc/self/statm", "r");
+	if (file) {
+		if (fscanf(file, "%*d %lld", &pages) == 1) {
+			stats.rss = pages * sysconf(_SC_PAGESIZE);
+		}
+		fclose(file);
+	}
+
+	char line[256];
+	long long kb;
+	file = fopen("/proc/self/smaps_rollup", "r");
+	if (file) {
+		while (fgets(line, sizeof(line), file)) {
+			if (sscanf(line, "AnonHugePages: %lld kB", &kb) == 1) {
+				stats.huge_pages = kb << 10;
+			}
+		}
+		fclose(file);
+	}
+	return stats;
+}
+
+// Appends `value` to the string of length `length` in `out`, with `format` if it's available, or "n/a".
+static int
+format_stat(char *out, size_t size, int length, const char *label, const char *format, double value, bool available)
+{
+	length += snprintf(out + length, size - length, "%s", label);
+	if (available) {
+		return length + snprintf(out + length, size - length, format, value);
+	}
+	return length + snprintf(out + length, size - length, "n/a");
+}
+
+static void
+format_memory_stats(const MemoryStats *stats, char *out, size_t size)
+{
+	int length = format_stat(out, size, 0, "RSS ", "%.1f MB", (double)stats->rss / (1 << 20), stats->rss >= 0);
+	format_stat(out, size, length, ", huge pages ", "%.1f MB", (double)stats->huge_pages / (1 << 20), stats->huge_pages >= 0);
+}
+
+// Describes the counters of `counters` per cell in `out`.
+static void
+format_counters(const Counters *counters, char *out, size_t size)
+{
+	int length = snprintf(out, size, "Per cell:");
+	for (int i = 0; i != COUNTER_COUNT; ++i) {
+		length = format_stat(out, size, length, i ? ", " : " ", "%.3g", counters->values[i] / counters->cells,
+							 counters->values[i] >= 0.0 && counters->cells > 0.0);
+		length += snprintf(out + length, size - length, " %s", counter_events[i].name);
+	}
+	format_stat(out, size, length, ", IPC ", "%.2f", counters->values[COUNTER_INSTRUCTIONS] / counters->values[COUNTER_CYCLES],
+				counters->values[COUNTER_INSTRUCTIONS] >= 0.0 && counters->values[COUNTER_CYCLES] > 0.0);
+}
+
+static void
+format_scheduler_stats(const SchedulerStats *stats, char *out, size_t size)
+{
+	snprintf(out, size, "Scheduler: %d thread(s), %.1f%% of %llu tile(s) active, %.1f steal(s) per step, %.1f%% idle", scheduler_threads,
+			 stats->tiles ? 100.0 * stats->active / stats->tiles : 0.0, (unsigned long long)(stats->steps ? stats->tiles / stats->steps : 0),
+			 stats->steps ? (double)stats->steals / stats->steps : 0.0, stats->busy + stats->idle > 0.0 ? 100.0 * stats->idle / (stats->busy + stats->idle) : 0.0);
+}
+
+
+// Soup census: runs many random soups to stabilization and counts the objects they leave.
+//
+// Each soup is a 16x16 random pattern in the middle of its own 64x64 universe, one 64 bits word per row,
+// so a whole row is stepped with a few bitwise operations (the neighbor counts are bit-sliced in 4 planes).
+// Every bit of a word is thus a cell doing useful work, as it would be with the boards packed in lanes, but
+// without stepping boards in lockstep and refilling the lanes of the ones that settled.
+//
+// The universe has dead borders: escaping gliders and other spaceships end up as debris on the border
+// instead of leaving. A soup is stable when its board repeats with a period of at most `CENSUS_MAX_PERIOD`.
+// Its objects are then the 8-connected groups of cells of its last phase, each only counted once checked to
+// evolve on its own as it did in the soup (see `census_group_check`). The ones that don't, such as the parts
+// of an oscillator whose phases aren't all connected, are merged with the groups they're connected to in
+// the other phases, or else with the ones within 2 cells, with which they interact, and checked again.
+// Objects within `CENSUS_MARGIN` cells of the border are discarded.
+//
+// Soups are split between the worker threads, each owning a range of soup indices. Workers take small
+// chunks from the front of their range, and when it's empty steal the back half of the largest other range,
+// so the threads stay busy even though soups take very different times to settle.
+//
+// Every soup is seeded from its index, so a census is reproducible whatever the number of threads.
+
+#define CENSUS_SIZE				64
+#define CENSUS_SOUP_SIZE		16
+#define CENSUS_MAX_PERIOD		6
+#define CENSUS_MAX_GENERATIONS	8000
+#define CENSUS_MARGIN			2
+#define CENSUS_CHUNK			16
+
+typedef struct {
+	char *		key;
+	uint64_t	count;
+} CensusObject;
+
+typedef struct {
+	CensusObject *	objects;
+	size_t			count;
+	size_t			capacity;
+} CensusTable;
+
+// Cells of an object in the last phase of the soup, the cells it covers in all the phases when it's alone, and
+// its own period (0 if it didn't check out).
+typedef struct {
+	uint64_t	cells[CENSUS_SIZE];
+	uint64_t	envelope[CENSUS_SIZE];
+	int			period;
+} CensusGroup;
+
+typedef struct {
+	pthread_t			thread;
+	int					index;
+	_Atomic uint64_t	range;
+	CensusTable			table;
+	CensusGroup *		groups;
+	size_t				group_capacity;
+	uint64_t			soups;
+	uint64_t			unstable;
+	uint64_t			discarded;
+	uint64_t			unverified;
+	uint64_t			generations;
+	uint64_t			steals;
+} CensusWorker;
+
+static CensusWorker *	census_workers		= NULL;
+static int				census_worker_count	= 0;
+static uint64_t			census_seed			= 0;
+
+static uint64_t
+splitmix64(uint64_t *state)
+{
+	uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+static void
+census_step(const uint64_t *in, uint64_t *out)
+{
+	for (int y = 0; y != CENSUS_SIZE; ++y) {
+		uint64_t up = y ? in[y - 1] : 0;
+		uint64_t mid = in[y];
+		uint64_t down = y != CENSUS_SIZE - 1 ? in[y + 1] : 0;
+		if ((up | mid | down) == 0 && (rule.birth & 1) == 0) {
+			out[y] = 0;
+			continue;
+		}
+
+		uint64_t neighbors[8] = { up << 1, up, up >> 1, mid << 1, mid >> 1, down << 1, down, down >> 1 };
+
+		// Bit-sliced counter: bit x of s0..s3 is the neighbor count of cell x.
+		uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+		for (int i = 0; i != 8; ++i) {
+			uint64_t c0 = s0 & neighbors[i];
+			s0 ^= neighbors[i];
+			uint64_t c1 = s1 & c0;
+			s1 ^= c0;
+			uint64_t c2 = s2 & c1;
+			s2 ^= c1;
+			s3 |= c2;
+		}
+
+		uint64_t born = 0, survive = 0;
+		for (int n = 0; n != 9; ++n) {
+			if (((rule.birth | rule.survive) >> n) & 1) {
+				uint64_t equal = ((n & 1) ? s0 : ~s0) & ((n & 2) ? s1 : ~s1) & ((n & 4) ? s2 : ~s2) & ((n & 8) ? s3 : ~s3);
+				born |= ((rule.birth >> n) & 1) ? equal : 0;
+				survive |= ((rule.survive >> n) & 1) ? equal : 0;
+			}
+		}
+		out[y] = (mid & survive) | (~mid & born);
+	}
+}
+
+static uint64_t
+census_hash(const uint64_t *board)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (int y = 0; y != CENSUS_SIZE; ++y) {
+		hash = (hash ^ board[y]) * 0x100000001b3ull;
+		hash ^= hash >> 29;
+	}
+	return hash;
+}
+
+// Cells within one cell of the cells of `in`.
+static void
+census_dilate(const uint64_t *in, uint64_t *out)
+{
+	for (int y = 0; y != CENSUS_SIZE; ++y) {
+		uint64_t rows = (y ? in[y - 1] : 0) | in[y] | (y != CENSUS_SIZE - 1 ? in[y + 1] : 0);
+		out[y] = rows | rows << 1 | rows >> 1;
+	}
+}
+
+// Checks that the cells of `group` evolve on their own as they do in the soup, whose `period` phases are
+// `phases`: alone in the universe, each of their phases must be the same as in the soup, with no other cell
+// around it. Fills the envelope of `group`, and returns its own period (a divisor of the soup's), or 0 if
+// it depends on the cells around it.
+static int
+census_group_check(uint64_t phases[][CENSUS_SIZE], int period, CensusGroup *group)
+{
+	uint64_t boards[2][CENSUS_SIZE];
+	memcpy(boards[0], group->cells, sizeof(boards[0]));
+	memcpy(group->envelope, group->cells, sizeof(group->envelope));
+
+	int current = 0, own = 0;
+	bool same = true;
+	for (int k = 1; k <= period; ++k) {
+		census_step(boards[current], boards[current ^ 1]);
+		current ^= 1;
+
+		uint64_t around[CENSUS_SIZE];
+		census_dilate(boards[current], around);
+		bool initial = true;
+		for (int y = 0; y != CENSUS_SIZE; ++y) {
+			group->envelope[y] |= boards[current][y];
+			same &= boards[current][y] == (phases[k % period][y] & around[y]);
+			initial &= boards[current][y] == group->cells[y];
+		}
+		own = own == 0 && initial ? k : own;
+	}
+	return same ? own : 0;
+}
+
+// Canonical key of the object `group`: the smallest of the 8 rotations / reflections of all its phases, so that
+// the same object is counted once whatever its orientation and phase.
+static char *
+census_object_key(const CensusGroup *group)
+{
+	uint64_t best[CENSUS_SIZE] = { 0 };
+	int best_w = 0, best_h = 0;
+
+	uint64_t boards[2][CENSUS_SIZE];
+	memcpy(boards[0], group->cells, sizeof(boards[0]));
+	for (int phase = 0; phase != group->period; ++phase) {
+		const uint64_t *board = boards[phase & 1];
+		uint64_t rows[CENSUS_SIZE] = { 0 }, columns = 0;
+		int min_y = CENSUS_SIZE, max_y = 0, min_x = 0, max_x = CENSUS_SIZE - 1;
+		for (int y = 0; y != CENSUS_SIZE; ++y) {
+			if (board[y]) {
+				min_y = y < min_y ? y : min_y;
+				max_y = y;
+				columns |= board[y];
+			}
+		}
+		while (((columns >> min_x) & 1) == 0) {
+			++min_x;
+		}
+		while (((columns >> max_x) & 1) == 0) {
+			--max_x;
+		}
+		int w = max_x - min_x + 1, h = max_y - min_y + 1;
+		for (int y = min_y; y <= max_y; ++y) {
+			rows[y - min_y] = board[y] >> min_x;
+		}
+
+		for (int transform = 0; transform != 8; ++transform) {
+			bool swap = transform & 4;
+			int tw = swap ? h : w;
+			int th = swap ? w : h;
+			uint64_t candidate[CENSUS_SIZE] = { 0 };
+			for (int y = 0; y != h; ++y) {
+				for (int x = 0; x != w; ++x) {
+					if ((rows[y] >> x) & 1) {
+						int tx = (transform & 1) ? w - 1 - x : x;
+						int ty = (transform & 2) ? h - 1 - y : y;
+						if (swap) {
+							int t = tx;
+							tx = ty;
+							ty = t;
+						}
+						candidate[ty] |= 1ull << tx;
+					}
+				}
+			}
+			if (best_w == 0 || tw < best_w || (tw == best_w && memcmp(candidate, best, sizeof(best)) < 0)) {
+				memcpy(best, candidate, sizeof(best));
+				best_w = tw;
+				best_h = th;
+			}
+		}
+		census_step(boards[phase & 1], boards[(phase & 1) ^ 1]);
+	}
+
+	char key[CENSUS_SIZE * 17 + 16];
+	int length = snprintf(key, sizeof(key), "p%d %dx%d", group->period, best_w, best_h);
+	for (int y = 0; y != best_h; ++y) {
+		length += snprintf(key + length, sizeof(key) - length, "%c%llx", y ? '.' : ':', (unsigned long long)best[y]);
+	}
+	return strdup(key);
+}
+
+static void
+census_table_add(CensusTable *table, char *key, uint64_t count)
+{
+	if (table->count * 2 >= table->capacity) {
+		CensusTable grown = { .capacity = table->capacity ? table->capacity * 2 : 256 };
+		grown.objects = calloc(grown.capacity, sizeof(CensusObject));
+		for (size_t i = 0; i != table->capacity; ++i) {
+			if (table->objects[i].key) {
+				census_table_add(&grown, table->objects[i].key, table->objects[i].count);
+			}
+		}
+		free(table->objects);
+		*table = grown;
+	}
+
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (const char *c = key; *c; ++c) {
+		hash = (hash ^ (uint8_t)*c) * 0x100000001b3ull;
+	}
+	for (size_t i = hash % table->capacity; ; i = (i + 1) % table->capacity) {
+		CensusObject *object = &table->objects[i];
+		if (object->key == NULL) {
+			object->key = key;
+			object->count = count;
+			++table->count;
+			return;
+		}
+		if (strcmp(object->key, key) == 0) {
+			object->count += count;
+			free(key);
+			return;
+		}
+	}
+}
+
+// Splits the stable board of period `period` in objects, and counts the ones that are far enough from the
+// border and check out on their own.
+static void
+census_count_objects(CensusWorker *worker, const uint64_t *board, int period)
+{
+	uint64_t phases[CENSUS_MAX_PERIOD][CENSUS_SIZE];
+	memcpy(phases[0], board, sizeof(phases[0]));
+	for (int k = 1; k != period; ++k) {
+		census_step(phases[k - 1], phases[k]);
+	}
+
+	uint64_t all[CENSUS_SIZE] = { 0 };
+	for (int k = 0; k != period; ++k) {
+		for (int y = 0; y != CENSUS_SIZE; ++y) {
+			all[y] |= phases[k][y];
+		}
+	}
+
+	// 8-connected groups of cells.
+	uint64_t remaining[CENSUS_SIZE];
+	memcpy(remaining, board, sizeof(remaining));
+	size_t count = 0;
+	for (int y0 = 0; y0 != CENSUS_SIZE; ++y0) {
+		while (remaining[y0]) {
+			if (count == worker->group_capacity) {
+				worker->group_capacity = worker->group_capacity ? worker->group_capacity * 2 : 64;
+				worker->groups = realloc(worker->groups, worker->group_capacity * sizeof(CensusGroup));
+			}
+			CensusGroup *group = &worker->groups[count++];
+			memset(group->cells, 0, sizeof(group->cells));
+
+			// Flood fill from the first remaining cell.
+			int stack[CENSUS_SIZE * CENSUS_SIZE];
+			int top = 0;
+			int x0 = 0;
+			while (((remaining[y0] >> x0) & 1) == 0) {
+				++x0;
+			}
+			remaining[y0] &= ~(1ull << x0);
+			stack[top++] = y0 * CENSUS_SIZE + x0;
+			while (top) {
+				int x = stack[--top] % CENSUS_SIZE;
+				int y = stack[top] / CENSUS_SIZE;
+				group->cells[y] |= 1ull << x;
+				for (int ny = y - 1; ny <= y + 1; ++ny) {
+					for (int nx = x - 1; nx <= x + 1; ++nx) {
+						if (nx >= 0 && nx < CENSUS_SIZE && ny >= 0 && ny < CENSUS_SIZE && ((remaining[ny] >> nx) & 1)) {
+							remaining[ny] &= ~(1ull << nx);
+							stack[top++] = ny * CENSUS_SIZE + nx;
+						}
+					}
+				}
+			}
+			group->period = census_group_check(phases, period, group);
+		}
+	}
+
+	// A group that doesn't check out interacts with others: merge it with the groups connected to it through
+	// the cells of all the phases, or if there are none with the groups within 2 cells of those (with which it
+	// shares neighbors), until it checks out or there are none left. Other groups that don't check out are
+	// merged first, so that an object that does isn't merged with its neighbors.
+	for (bool merged = true; merged;) {
+		merged = false;
+		for (size_t i = 0; i != count; ++i) {
+			CensusGroup *group = &worker->groups[i];
+			bool empty = true;
+			for (int y = 0; y != CENSUS_SIZE; ++y) {
+				empty &= group->cells[y] == 0;
+			}
+			if (group->period || empty) {
+				continue;
+			}
+
+			uint64_t connected[CENSUS_SIZE], close[CENSUS_SIZE], grown[CENSUS_SIZE];
+			memcpy(connected, group->cells, sizeof(connected));
+			for (bool growing = true; growing;) {
+				census_dilate(connected, grown);
+				growing = false;
+				for (int y = 0; y != CENSUS_SIZE; ++y) {
+					grown[y] &= all[y];
+					growing |= grown[y] != connected[y];
+					connected[y] = grown[y];
+				}
+			}
+			census_dilate(connected, grown);
+			census_dilate(grown, close);
+
+			// Connected groups that don't check out, close ones that don't, connected ones, and close ones.
+			bool merging = false;
+			for (int level = 0; level != 4 && merging == false; ++level) {
+				const uint64_t *reach = level & 1 ? close : connected;
+				for (size_t j = 0; j != count; ++j) {
+					CensusGroup *other = &worker->groups[j];
+					bool touches = false;
+					for (int y = 0; j != i && y != CENSUS_SIZE; ++y) {
+						touches |= (other->cells[y] & reach[y]) != 0;
+					}
+					if (touches && (level >= 2 || other->period == 0)) {
+						for (int y = 0; y != CENSUS_SIZE; ++y) {
+							group->cells[y] |= other->cells[y];
+							other->cells[y] = 0;
+							other->envelope[y] = 0;
+						}
+						merging = true;
+					}
+				}
+			}
+			if (merging) {
+				group->period = census_group_check(phases, period, group);
+				merged = true;
+			}
+		}
+	}
+
+	for (size_t i = 0; i != count; ++i) {
+		const CensusGroup *group = &worker->groups[i];
+		uint64_t columns = 0;
+		int min_y = CENSUS_SIZE, max_y = -1;
+		for (int y = 0; y != CENSUS_SIZE; ++y) {
+			if (group->envelope[y]) {
+				min_y = y < min_y ? y : min_y;
+				max_y = y;
+				columns |= group->envelope[y];
+			}
+		}
+		if (max_y < 0) {
+			continue;
+		}
+
+		uint64_t margin = (1ull << CENSUS_MARGIN) - 1;
+		if (min_y < CENSUS_MARGIN || max_y >= CENSUS_SIZE - CENSUS_MARGIN || (columns & (margin | margin << (CENSUS_SIZE - CENSUS_MARGIN)))) {
+			++worker->discarded;
+		} else if (group->period == 0) {
+			++worker->unverified;
+		} else {
+			census_table_add(&worker->table, census_object_key(group), 1);
+		}
+	}
+}
+
+static void
+census_run_soup(CensusWorker *worker, uint64_t index)
+{
+	uint64_t boards[2][CENSUS_SIZE] = { 0 };
+	uint64_t state = census_seed ^ (index * 0xd1342543de82ef95ull);
+	for (int y = 0; y != CENSUS_SOUP_SIZE; ++y) {
+		uint64_t row = splitmix64(&state) & ((1ull << CENSUS_SOUP_SIZE) - 1);
+		boards[0][(CENSUS_SIZE - CENSUS_SOUP_SIZE) / 2 + y] = row << ((CENSUS_SIZE - CENSUS_SOUP_SIZE) / 2);
+	}
+
+	uint64_t history[CENSUS_MAX_PERIOD + 1] = { 0 };
+	history[0] = census_hash(boards[0]);
+	int current = 0;
+	for (int generation = 1; generation <= CENSUS_MAX_GENERATIONS; ++generation) {
+		census_step(boards[current], boards[current ^ 1]);
+		current ^= 1;
+		++worker->generations;
+
+		uint64_t hash = census_hash(boards[current]);
+		for (int period = 1; period <= CENSUS_MAX_PERIOD && period <= generation; ++period) {
+			if (history[(generation - period) % (CENSUS_MAX_PERIOD + 1)] == hash) {
+				census_count_objects(worker, boards[current], period);
+				++worker->soups;
+				return;
+			}
+		}
+		history[generation % (CENSUS_MAX_PERIOD + 1)] = hash;
+	}
+
+	++worker->unstable;
+	++worker->soups;
+}
+
+// Steals the back half of the largest range of the other workers, and makes it the worker's own range.
+static bool
+census_steal(CensusWorker *worker)
+{
+	if (range_steal(&worker->range, &census_workers[0].range, sizeof(CensusWorker), census_worker_count) == false) {
+		return false;
+	}
+	++worker->steals;
+	return true;
+}
+
+static void *
+census_thread(void *data)
+{
+	CensusWorker *worker = data;
+	uint32_t begin, end;
+	while (range_take(&worker->range, CENSUS_CHUNK, &begin, &end) ||
+		   (census_steal(worker) && range_take(&worker->range, CENSUS_CHUNK, &begin, &end))) {
+		for (uint32_t index = begin; index != end; ++index) {
+			census_run_soup(worker, index);
+		}
+	}
+	return NULL;
+}
+
+static int
+census_compare(const void *a, const void *b)
+{
+	const CensusObject *first = a;
+	const CensusObject *second = b;
+	return first->count != second->count ? (first->count < second->count ? 1 : -1) : strcmp(first->key, second->key);
+}
+
+// Runs the census of `soups` soups on `threads` threads, and writes the object counts to `output`.
+static int
+run_census(uint64_t soups, int threads, const char *output)
+{
+	if (soups > UINT32_MAX) {
+		fprintf(stderr, "At most %u soups per census.\n", UINT32_MAX);
+		return 1;
+	}
+
+	census_seed = cell_seed ? cell_seed : (uint64_t)time(0);
+	census_worker_count = threads;
+	census_workers = calloc(threads, sizeof(CensusWorker));
+	for (int i = 0; i != threads; ++i) {
+		census_workers[i].index = i;
+		atomic_init(&census_workers[i].range, RANGE(soups * i / threads, soups * (i + 1) / threads));
+	}
+
+	double begin = get_time();
+	for (int i = 0; i != threads; ++i) {
+		pthread_create(&census_workers[i].thread, NULL, census_thread, &census_workers[i]);
+	}
+
+	// Merge the results of all the workers.
+	CensusTable total = { 0 };
+	uint64_t unstable = 0, discarded = 0, unverified = 0, generations = 0, steals = 0, objects = 0;
+	for (int i = 0; i != threads; ++i) {
+		CensusWorker *worker = &census_workers[i];
+		pthread_join(worker->thread, NULL);
+		for (size_t j = 0; j != worker->table.capacity; ++j) {
+			if (worker->table.objects[j].key) {
+				census_table_add(&total, worker->table.objects[j].key, worker->table.objects[j].count);
+				objects += worker->table.objects[j].count;
+			}
+		}
+		free(worker->table.objects);
+		free(worker->groups);
+		unstable += worker->unstable;
+		discarded += worker->discarded;
+		unverified += worker->unverified;
+		generations += worker->generations;
+		steals += worker->steals;
+	}
+	double elapsed = get_time() - begin;
+
+	printf("%llu soups in %.3f s on %d thread(s): %.0f soups/s, %.2f Mgenerations/s, %llu steal(s)\n", (unsigned long long)soups,
+		   elapsed, threads, soups / elapsed, generations / elapsed * 1e-6, (unsigned long long)steals);
+	printf("%llu objects of %zu kinds, %llu soup(s) didn't stabilize in %d generations\n", (unsigned long long)objects,
+		   total.count, (unsigned long long)unstable, CENSUS_MAX_GENERATIONS);
+	printf("%llu object(s) discarded near the border, %llu object(s) not stable on their own\n", (unsigned long long)discarded,
+		   (unsigned long long)unverified);
+
+	FILE *file = fopen(output, "w");
+	if (file == NULL) {
+		fprintf(stderr, "Couldn't open '%s' for writing.\n", output);
+		return 1;
+	}
+
+	// Compact and sort by decreasing count.
+	size_t count = 0;
+	for (size_t i = 0; i != total.capacity; ++i) {
+		if (total.objects[i].key) {
+			total.objects[count++] = total.objects[i];
+		}
+	}
+	qsort(total.objects, count, sizeof(CensusObject), census_compare);
+
+	fprintf(file, "# soups %llu, seed %llu, unstable %llu, objects %llu, discarded %llu, unverified %llu\n", (unsigned long long)soups,
+			(unsigned long long)census_seed, (unsigned long long)unstable, (unsigned long long)objects, (unsigned long long)discarded,
+			(unsigned long long)unverified);
+	fprintf(file, "# count p<period> <width>x<height>:<hex rows>\n");
+	for (size_t i = 0; i != count; ++i) {
+		fprintf(file, "%llu %s\n", (unsigned long long)total.objects[i].count, total.objects[i].key);
+	}
+	fclose(file);
+
+	printf("Census written to '%s'.\n", output);
+	return 0;
+}
+
+
+// Conformance check: every engine is run on a corpus of known patterns and random boards of odd sizes
+// (including widths that are not a multiple of 8 or 64, and boards smaller than the engines' blocks), and
+// the hash of its board is compared to the reference kernel's after every step.
+
+typedef struct {
+	const char *	name;
+	const char *	rows;
+} CheckPattern;
+
+static const CheckPattern check_patterns[] = {
+	{ "blinker",		"OOO" },
+	{ "toad",			".OOO|OOO." },
+	{ "beacon",			"OO..|OO..|..OO|..OO" },
+	{ "pulsar",			"..OOO...OOO..|.............|O....O.O....O|O....O.O....O|O....O.O....O|..OOO...OOO..|.............|"
+						"..OOO...OOO..|O....O.O....O|O....O.O....O|O....O.O....O|.............|..OOO...OOO.." },
+	{ "glider",			".O.|..O|OOO" },
+	{ "lwss",			".O..O|O....|O...O|OOOO." },
+	{ "r-pentomino",	".OO|OO.|.O." },
+	{ "acorn",			".O.....|...O...|OO..OOO" },
+	{ "diehard",		"......O.|OO......|.O...OOO" },
+	{ "gosper-gun",		"........................O...........|......................O.O...........|"
+						"............OO......OO............OO|...........O...O....OO............OO|"
+						"OO........O.....O...OO..............|OO........O...O.OO....O.O...........|"
+						"..........O.....O.......O...........|...........O...O....................|"
+						"............OO......................" },
+};
+
+static const int check_sizes[][2] = {
+	{ 64, 64 }, { 61, 47 }, { 65, 33 }, { 127, 9 }, { 1, 1 }, { 2, 2 }, { 3, 5 }, { 7, 9 },
+	{ 63, 17 }, { 129, 7 }, { 513, 9 }, { 250, 130 }, { 9, 300 }, { 600, 5 }, { 260, 200 },
+};
+
+// With `--check-cases <file>`, the initial board and the reference hashes of every case are also written to
+// `file`, one line per case, so that the library can be checked against them (see gol_check.c):
+//
+//	<name> <rule> <width> <height> <generations> <hex words of the packed board> <hex hash of each generation from 0>
+static FILE *	check_cases	= NULL;
+
+static bool check_dirty(int mask, int next_mask);
+static int run_export(const char *path, int frames, int every, int scale);
+
+static const char *check_rules[] = { "B3/S23", "B36/S23", "B3678/S34678", "B2/S", "R1,C0,M1,S3..4,B3..3,NM", "R5,C0,M1,S34..58,B34..45,NM" };
+
+// Clears the board and puts `pattern` in its middle.
+static void
+check_place(const char *rows, int mask)
+{
+	memset(cells, 0, (size_t)cell_count_w * cell_count_h);
+	int width = (int)(strchr(rows, '|') ? strchr(rows, '|') - rows : (int)strlen(rows));
+	int64_t x0 = (cell_count_w - width) / 2;
+	int64_t y = cell_count_h / 2 - 4;
+	for (int64_t x = 0; *rows; ++rows) {
+		if (*rows == '|') {
+			++y;
+			x = 0;
+		} else {
+			if (*rows == 'O') {
+				CELL(x0 + x, y) = (char)mask;
+			}
+			++x;
+		}
+	}
+}
+
+// Runs `generations` generations of every engine from the same initial board (`pattern`, or random if NULL)
+// and compares them to the reference. Returns the number of failures.
+static int
+check_case(const char *name, const char *pattern, int generations)
+{
+	static uint64_t *expected = NULL;
+	static int expected_size = 0;
+	if (expected_size < generations + 1) {
+		free(expected);
+		expected = malloc((generations + 1) * sizeof(uint64_t));
+		expected_size = generations + 1;
+	}
+
+	int failures = 0;
+	for (int e = 0; e != ENGINE_COUNT; ++e) {
+		if (engines[e].max_radius < rule.radius) {
+			continue;
+		}
+		engine = e;
+		int mask = ALIVE_MASK_1;
+		init_cells((char)mask);
+		if (pattern) {
+			check_place(pattern, mask);
+		}
+
+		int done = 0;
+		if (e == 0) {
+			expected[0] = hash_cells(mask);
+		}
+
+		// The library has no generations per block.
+		if (e == 0 && check_cases && block_gens == 1) {
+			size_t word_count = delta_word_count(cell_count_w, cell_count_h);
+			uint64_t *words = malloc(word_count * 8);
+			pack_cells(mask, words);
+			fprintf(check_cases, "%s %s %lld %lld %d", name, rule_to_string(), (long long)cell_count_w, (long long)cell_count_h, generations);
+			for (size_t i = 0; i != word_count; ++i) {
+				fprintf(check_cases, " %llx", (unsigned long long)words[i]);
+			}
+			free(words);
+		}
+		while (done < generations) {
+			int next_mask = mask == ALIVE_MASK_1 ? ALIVE_MASK_2 : ALIVE_MASK_1;
+			// The reference steps the whole board, the engines only the active tiles (on all the threads).
+			for (int64_t i = 0; i != dirty_w * dirty_h; ++i) {
+				dirty[i] &= (uint8_t)~DIRTY_REPAINT;
+			}
+			done += e == 0 ? engines[e].step(mask, next_mask, 0, cell_count_w, 0, cell_count_h) : step_cells(mask, next_mask);
+			if (check_dirty(mask, next_mask) == false) {
+				printf("FAIL %-10s %s, %lldx%lld, rule %s, %d generation(s) per block: unflagged change at generation %d\n", engines[e].name,
+					   name, (long long)cell_count_w, (long long)cell_count_h, rule_to_string(), block_gens, done);
+				++failures;
+				break;
+			}
+			mask = next_mask;
+			if (e == 0) {
+				expected[done] = hash_cells(mask);
+			} else if (done <= generations && hash_cells(mask) != expected[done]) {
+				printf("FAIL %-10s %s, %lldx%lld, rule %s, %d generation(s) per block: differs at generation %d\n", engines[e].name,
+					   name, (long long)cell_count_w, (long long)cell_count_h, rule_to_string(), block_gens, done);
+				++failures;
+				break;
+			}
+		}
 
-#include <stdlib.h>
-#include <stdint.h>
-#include <time.h>
+		if (e == 0 && check_cases && block_gens == 1) {
+			for (int i = 0; i <= generations; ++i) {
+				fprintf(check_cases, " %llx", (unsigned long long)expected[i]);
+			}
+			fprintf(check_cases, "\n");
+		}
+	}
+	return failures;
+}
 
+// Checks that every cell that changed from the `mask` bit to the `next_mask` bit is in a tile with both flags.
+static bool
+check_dirty(int mask, int next_mask)
+{
+	for (int64_t y = 0; y != cell_count_h; ++y) {
+		const char *row = &cells[y * cell_count_w];
+		for (int64_t x = 0; x != cell_count_w; ++x) {
+			if (((row[x] & mask) != 0) != ((row[x] & next_mask) != 0) && DIRTY_ROW(y)[x >> DIRTY_TILE_SHIFT] != DIRTY_ALL) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
 
-static char *	cells				= NULL;
-static int		cell_target_size	= 2;
-static int		cell_count_w		= 0;
-static int		cell_count_h		= 0;
-static Vector2	cell_size			= { 0 };
-static int		cell_prob			= (int)(50.0 * (double)RAND_MAX / 100.0);
+// Reader of the export check: reads the first 2 MB written to the FIFO `data`, and goes away. It stops reading
+// for a while first, so that all the queues of the export are full when the writes fail.
+static void *
+check_export_reader(void *data)
+{
+	int fd = open(data, O_RDONLY);
+	char buffer[1 << 16];
+	for (size_t total = 0; fd >= 0 && total < 2 << 20;) {
+		ssize_t count = read(fd, buffer, sizeof(buffer));
+		if (count <= 0) {
+			break;
+		}
+		total += (size_t)count;
+	}
+	sleep_ms(100);
+	if (fd >= 0) {
+		close(fd);
+	}
+	return NULL;
+}
 
+// Checks that an export whose writes start failing partway stops with an error, instead of waiting forever for
+// the writer: the frames go to a FIFO whose reader goes away after a few of them. A hang is stopped by an alarm,
+// which kills the check.
+static int
+check_export(void)
+{
+	char directory[] = "/tmp/game_of_life_check_XXXXXX", path[64];
+	if (mkdtemp(directory) == NULL || snprintf(path, sizeof(path), "%s/export.y4m", directory) >= (int)sizeof(path) ||
+		mkfifo(path, 0600) != 0) {
+		printf("FAIL export: couldn't create a FIFO in /tmp\n");
+		return 1;
+	}
+	signal(SIGPIPE, SIG_IGN);
+	pthread_t reader;
+	pthread_create(&reader, NULL, check_export_reader, path);
 
-#define ALIVE_MASK_1	(1 << 7)
-#define ALIVE_MASK_2	(1 << 6)
-#define CELL(x, y)		(cells[mod((y), cell_count_h) * cell_count_w + mod((x), cell_count_w)])
+	rule_parse("B3/S23", &rule);
+	init_rule();
+	engine = 0;
+	block_gens = 1;
+	cell_count_w = 64;
+	cell_count_h = 64;
+	alarm(60);
+	int result = run_export(path, 1000, 1, 8);
+	alarm(0);
 
+	pthread_join(reader, NULL);
+	unlink(path);
+	rmdir(directory);
+	if (result == 0) {
+		printf("FAIL export: no error when the writes fail\n");
+		return 1;
+	}
+	return 0;
+}
 
+// Checks that a recording seeks back to the boards it recorded, when the board is reset after a few
+// generations: records them, resets the board and steps it, and seeks every recorded generation the way the
+// player does (from the last keyframe before it).
 static int
-mod(int a, int b)
+check_recording(void)
 {
-	a = a % b;
-	return a < 0 ? a + b : a;
+	enum { GENERATIONS = 20 };
+	char directory[] = "/tmp/game_of_life_check_XXXXXX", path[64];
+	if (mkdtemp(directory) == NULL || snprintf(path, sizeof(path), "%s/check.golr", directory) >= (int)sizeof(path)) {
+		printf("FAIL recording: couldn't create a directory in /tmp\n");
+		return 1;
+	}
+
+	rule_parse("B3/S23", &rule);
+	init_rule();
+	engine = 0;
+	block_gens = 1;
+	cell_count_w = 61;
+	cell_count_h = 47;
+	uint64_t interval = keyframe_interval;
+	keyframe_interval = 8;
+	int mask = ALIVE_MASK_1;
+	uint64_t expected[GENERATIONS + 1];
+	init_cells((char)mask);
+	recording_start(path);
+	publish_step(mask, 0);
+	expected[0] = hash_cells(mask);
+	for (int i = 1; i <= GENERATIONS; ++i) {
+		int next_mask = mask == ALIVE_MASK_1 ? ALIVE_MASK_2 : ALIVE_MASK_1;
+		publish_step(next_mask, step_cells(mask, next_mask));
+		mask = next_mask;
+		expected[i] = hash_cells(mask);
+	}
+	reset_board(mask);
+	for (int i = 0; i != 3; ++i) {
+		int next_mask = mask == ALIVE_MASK_1 ? ALIVE_MASK_2 : ALIVE_MASK_1;
+		publish_step(next_mask, step_cells(mask, next_mask));
+		mask = next_mask;
+	}
+	recording_stop();
+	keyframe_interval = interval;
+
+	FILE *file = fopen(path, "rb");
+	FILE *index = fopen(TextFormat("%s.idx", path), "rb");
+	DeltaIndexEntry keyframes[GENERATIONS + 2];
+	size_t keyframe_count = index ? fread(keyframes, sizeof(DeltaIndexEntry), GENERATIONS + 2, index) : 0;
+	size_t word_count = delta_word_count(cell_count_w, cell_count_h);
+	uint64_t *words = malloc(word_count * 8);
+	uint8_t *payload = malloc(delta_encode_bound(word_count));
+	int failures = 0;
+	for (uint64_t target = 0; file && keyframe_count && target <= GENERATIONS + 1 && failures == 0; ++target) {
+		size_t first = 0;
+		while (first + 1 < keyframe_count && keyframes[first + 1].generation <= target) {
+			++first;
+		}
+		fseek(file, (long)keyframes[first].offset, SEEK_SET);
+		uint64_t reached = UINT64_MAX;
+		DeltaRecord record;
+		while (fread(&record, sizeof(record), 1, file) == 1 && record.generation <= target && record.size <= delta_encode_bound(word_count) &&
+			   fread(payload, 1, record.size, file) == record.size) {
+			if (record.type == DELTA_RECORD_KEYFRAME) {
+				memset(words, 0, word_count * 8);
+			}
+			delta_apply(payload, record.size, words, word_count);
+			reached = record.generation;
+		}
+
+		// Nothing after the reset was recorded.
+		if (target <= GENERATIONS ? reached != target || delta_hash_cells(words, (size_t)(cell_count_w * cell_count_h)) != expected[target]
+								  : reached != GENERATIONS) {
+			printf("FAIL recording: seeking generation %llu gives another board\n", (unsigned long long)target);
+			++failures;
+		}
+	}
+	if (file == NULL || keyframe_count == 0) {
+		printf("FAIL recording: couldn't read '%s'\n", path);
+		++failures;
+	}
+
+	free(words);
+	free(payload);
+	if (file) {
+		fclose(file);
+	}
+	if (index) {
+		fclose(index);
+	}
+	unlink(path);
+	unlink(TextFormat("%s.idx", path));
+	rmdir(directory);
+	return failures;
 }
 
+static int
+run_check(const char *cases_path)
+{
+	int failures = 0;
+	int cases = 0;
+
+	if (cases_path && (check_cases = fopen(cases_path, "w")) == NULL) {
+		fprintf(stderr, "Couldn't open '%s' for writing.\n", cases_path);
+		return 1;
+	}
 
-static void
-init_cells(char alive)
+	for (int r = 0; r != (int)(sizeof(check_rules) / sizeof(check_rules[0])); ++r) {
+		rule_parse(check_rules[r], &rule);
+		init_rule();
+
+		// Only the blocked engine depends on the generations per block, and it only supports radius 1.
+		for (int b = 1; b <= (rule.radius == 1 ? 3 : 1); b += 2) {
+			block_gens = b;
+			for (int i = 0; i != (int)(sizeof(check_sizes) / sizeof(check_sizes[0])); ++i) {
+				cell_count_w = check_sizes[i][0];
+				cell_count_h = check_sizes[i][1];
+
+				// Known patterns (only with Conway's rule, and when they fit).
+				for (int p = 0; r == 0 && p != (int)(sizeof(check_patterns) / sizeof(check_patterns[0])); ++p) {
+					const char *rows = check_patterns[p].rows;
+					int width = (int)(strchr(rows, '|') ? strchr(rows, '|') - rows : (int)strlen(rows));
+					if (width <= cell_count_w && 8 <= cell_count_h) {
+						failures += check_case(check_patterns[p].name, rows, 96);
+						++cases;
+					}
+				}
+
+				// Random boards.
+				for (uint32_t seed = 1; seed <= 3; ++seed) {
+					cell_seed = seed * 7919 + (uint32_t)i;
+					failures += check_case("random", NULL, 48);
+					++cases;
+				}
+			}
+		}
+	}
+
+	if (check_cases) {
+		fclose(check_cases);
+	}
+
+	failures += check_export();
+	failures += check_recording();
+	cases += 2;
+
+	printf("%d case(s), %d engine(s): %d failure(s)\n", cases, ENGINE_COUNT, failures);
+	return failures ? 1 : 0;
+}
+
+
+// Cells the blocked kernel loads along a dimension of `count` cells, stepped in ranges of `range` cells (the
+// last one taking the remainder when `merge_last`, as the scheduler's tiles do) that it splits in tiles of
+// `tile` cells, each loaded with a halo of `gens` cells on both sides.
+static double
+blocked_extent(int64_t count, int64_t range, bool merge_last, int64_t tile, int gens)
 {
-	if (cells) {
-		free(cells);
+	double extent = 0.0;
+	for (int64_t begin = 0; begin < count;) {
+		int64_t end = begin + range < count && (merge_last == false || begin + 2 * range <= count) ? begin + range : count;
+		for (int64_t t = begin; t < end; t += tile) {
+			extent += (double)((end - t < tile ? end - t : tile) + 2 * gens);
+		}
+		begin = end;
+	}
+	return extent;
+}
+
+// Headless benchmark: steps a fixed size board for a number of generations without opening a window,
+// and prints the throughput of the current engine, or of all of them if `engine` is -1. If `report` is
+// not NULL, the throughput of each engine in millions of cells per second is also written to that file
+// (one "<mcells> <engine>" line per engine) so that build scripts can compare builds.
+static int
+run_benchmark(int generations, const char *report)
+{
+	FILE *file = NULL;
+	if (report) {
+		file = fopen(report, "w");
+		if (file == NULL) {
+			fprintf(stderr, "Couldn't open '%s' for writing.\n", report);
+			return 1;
+		}
+	}
+
+	int first = engine < 0 ? 0 : engine;
+	int last = engine < 0 ? ENGINE_COUNT : engine + 1;
+	for (int e = first; e != last; ++e) {
+		if (engines[e].max_radius < rule.radius) {
+			continue;
+		}
+		engine = e;
+
+		// Same seed for each engine, so that the final hashes can be compared. An out-of-core board goes on
+		// from its current generation instead.
+		int mask = board_file.map ? board_file.header->mask : ALIVE_MASK_1;
+		if (board_file.map == NULL) {
+			init_cells((char)mask);
+		}
+		publish_step(mask, 0);
+
+		int done = 0;
+		counters_total = (Counters){ 0 };
+		scheduler_total = (SchedulerStats){ 0 };
+		double begin = get_time();
+		while (done < generations) {
+			int next_mask = mask == ALIVE_MASK_1 ? ALIVE_MASK_2 : ALIVE_MASK_1;
+			int gens = step_cells(mask, next_mask);
+			generation += gens;
+			publish_step(next_mask, gens);
+			done += gens;
+			mask = next_mask;
+		}
+		double elapsed = get_time() - begin;
+		MemoryStats memory = read_memory_stats();
+
+		double mcells = (double)cell_count_w * cell_count_h * done / elapsed * 1e-6;
+		printf("%-10s %lldx%lld board, %d generations in %.3f s: %8.2f Mcells/s, hash %016llx\n", engines[e].name,
+			   (long long)cell_count_w, (long long)cell_count_h, done, elapsed, mcells, (unsigned long long)hash_cells(mask));
+
+		// Model of the traffic between the board and the caches: each step loads the board with the halos of
+		// the tiles the blocked kernel is actually given (the scheduler's, or the bands of a board file), and
+		// writes it back, once per step instead of once per generation.
+		if (engines[e].step == step_blocked) {
+			int64_t range_w = board_file.map ? cell_count_w : 1 << SCHEDULER_TILE_SHIFT;
+			int64_t range_h = board_file.map ? board_file.band_rows : 1 << SCHEDULER_TILE_SHIFT;
+			double loaded = blocked_extent(cell_count_w, range_w, board_file.map == NULL, BLOCK_TILE_W, block_gens) *
+							blocked_extent(cell_count_h, range_h, board_file.map == NULL, BLOCK_TILE_H, block_gens) /
+							((double)cell_count_w * cell_count_h);
+			printf("%-10s %d generation(s) per block on %lldx%lld tiles: ~%.2f board bytes streamed per generation and cell (model estimate)\n",
+				   "", block_gens, (long long)(range_w < BLOCK_TILE_W ? range_w : BLOCK_TILE_W),
+				   (long long)(range_h < BLOCK_TILE_H ? range_h : BLOCK_TILE_H), (loaded + 1.0) / block_gens);
+		}
+
+		// Measured traffic, from the last level cache misses (of 64 bytes lines).
+		if (counters_enabled && counters_total.values[COUNTER_LLC_MISSES] >= 0.0 && counters_total.cells > 0.0) {
+			printf("%-10s ~%.2f bytes read from memory per generation and cell (measured LLC read misses)\n", "",
+				   counters_total.values[COUNTER_LLC_MISSES] * 64.0 / counters_total.cells);
+		}
+
+		char stats[256];
+		format_memory_stats(&memory, stats, sizeof(stats));
+		printf("%-10s %s\n", "", stats);
+		if (counters_enabled) {
+			format_counters(&counters_total, stats, sizeof(stats));
+			printf("%-10s %s\n", "", stats);
+		}
+		if (board_file.map == NULL) {
+			format_scheduler_stats(&scheduler_total, stats, sizeof(stats));
+			printf("%-10s %s\n", "", stats);
+		}
+
+		// Each step reads the whole board from the file and writes it back.
+		if (board_file.map) {
+			double steps = engines[e].step == step_blocked ? (double)done / block_gens : done;
+			printf("%-10s out-of-core, %.1f MB/s of board read and written back\n", "",
+				   2.0 * (double)cell_count_w * cell_count_h * steps / elapsed / (1 << 20));
+		}
+
+		if (file) {
+			fprintf(file, "%f %s\n", mcells, engines[e].name);
+		}
+	}
+
+	if (file) {
+		fclose(file);
+	}
+	return 0;
+}
+
+
+// Video export: with `--export <file>`, the board is stepped headless and every `--export-every <n>`th
+// generation is rendered with `--export-scale <n>` pixels per cell, then written in a raw Y4M video if the
+// name of the file ends with ".y4m", or as a PNG sequence otherwise (the name being a pattern such as
+// "frame%05d.png", see `export_pattern`).
+//
+// The simulation, the rasterization and the writing run on 3 threads linked by queues: the simulation only
+// packs the generations to export, the rasterizer turns them into frames, and the writer encodes them. On a
+// multi-core machine the export thus runs at the speed of the slowest stage, which is reported at the end.
+
+#define EXPORT_QUEUE_SIZE	8
+#define EXPORT_FPS			30
+#define EXPORT_ALIVE		245	// Luma of RAYWHITE
+#define EXPORT_DEAD			80	// and DARKGRAY, as in the game.
+
+enum {
+	EXPORT_SIMULATION,
+	EXPORT_RASTERIZATION,
+	EXPORT_WRITING,
+	EXPORT_STAGE_COUNT,
+};
+
+// Header of the slots of both queues, followed by the packed board / the frame.
+typedef struct {
+	uint64_t	frame;
+} ExportSlot;
+
+typedef struct {
+	const char *	path;
+	char			pattern[4096];
+	bool			y4m;
+	FILE *			file;
+	int				scale;
+	int				width;
+	int				height;
+	size_t			word_count;
+	Queue			boards;
+	Queue			frames;
+	atomic_bool		done[EXPORT_STAGE_COUNT];
+	atomic_bool		failed;
+	double			busy[EXPORT_STAGE_COUNT];
+} Exporter;
+
+static Exporter exporter = { 0 };
+
+// Makes the format of the names of the PNG files from `path` into `pattern`. `path` may have a single integer
+// conversion for the frame number ("%d" or "%0<width>d"), and "%%" for a literal '%'. Without a conversion,
+// "_%06d" is inserted before the extension. Returns false for any other conversion, or too long a path.
+static bool
+export_pattern(const char *path, char *pattern, size_t size)
+{
+	int conversions = 0;
+	for (const char *c = path; *c != '\0'; ++c) {
+		if (*c != '%') {
+			continue;
+		}
+		if (c[1] == '%') {
+			++c;
+			continue;
+		}
+		const char *end = c + 1 + (c[1] == '0');
+		while (*end >= '0' && *end <= '9') {
+			++end;
+		}
+		if (*end != 'd' || ++conversions > 1) {
+			return false;
+		}
+		c = end;
+	}
+
+	if (conversions == 1) {
+		return (size_t)snprintf(pattern, size, "%s", path) < size;
+	}
+	const char *slash = strrchr(path, '/');
+	const char *dot = strrchr(path, '.');
+	int stem = dot != NULL && (slash == NULL || dot > slash) ? (int)(dot - path) : (int)strlen(path);
+	return (size_t)snprintf(pattern, size, "%.*s_%%06d%s", stem, path, path + stem) < size;
+}
+
+static void *
+export_rasterizer(void *data)
+{
+	(void)data;
+
+	// Once the writer failed, the frames are never consumed: stop, or this waits for them forever.
+	while (atomic_load(&exporter.failed) == false) {
+		bool done = atomic_load(&exporter.done[EXPORT_SIMULATION]);
+		ExportSlot *board = queue_front(&exporter.boards);
+		ExportSlot *frame = board ? queue_push_begin(&exporter.frames) : NULL;
+		if (frame == NULL) {
+			if (board == NULL && done) {
+				break;
+			}
+			sleep_ms(1);
+			continue;
+		}
+
+		// Each row of cells gives a row of pixels, repeated `scale` times.
+		double begin = get_time();
+		const uint64_t *words = (const uint64_t *)(board + 1);
+		uint8_t *pixels = (uint8_t *)(frame + 1);
+		for (int64_t y = 0; y != cell_count_h; ++y) {
+			uint8_t *row = pixels + (size_t)y * exporter.scale * exporter.width;
+			for (int64_t x = 0; x != cell_count_w; ++x) {
+				size_t i = (size_t)(y * cell_count_w + x);
+				memset(row + x * exporter.scale, (words[i / 64] >> (i % 64)) & 1 ? EXPORT_ALIVE : EXPORT_DEAD, exporter.scale);
+			}
+			for (int j = 1; j != exporter.scale; ++j) {
+				memcpy(row + (size_t)j * exporter.width, row, exporter.width);
+			}
+		}
+		frame->frame = board->frame;
+		exporter.busy[EXPORT_RASTERIZATION] += get_time() - begin;
+
+		queue_push_end(&exporter.frames);
+		queue_pop(&exporter.boards);
+	}
+
+	atomic_store(&exporter.done[EXPORT_RASTERIZATION], true);
+	return NULL;
+}
+
+static void *
+export_writer(void *data)
+{
+	(void)data;
+
+	// 4:2:0 with neutral chroma planes, the most widely supported gray format.
+	size_t chroma = (size_t)((exporter.width + 1) / 2) * ((exporter.height + 1) / 2);
+	uint8_t *neutral = malloc(2 * chroma);
+	memset(neutral, 128, 2 * chroma);
+
+	for (;;) {
+		bool done = atomic_load(&exporter.done[EXPORT_RASTERIZATION]);
+		ExportSlot *frame = queue_front(&exporter.frames);
+		if (frame == NULL) {
+			if (done) {
+				break;
+			}
+			sleep_ms(1);
+			continue;
+		}
+
+		double begin = get_time();
+		uint8_t *pixels = (uint8_t *)(frame + 1);
+		bool written;
+		if (exporter.y4m) {
+			written = fputs("FRAME\n", exporter.file) >= 0 &&
+					  fwrite(pixels, (size_t)exporter.width * exporter.height, 1, exporter.file) == 1 &&
+					  fwrite(neutral, 2 * chroma, 1, exporter.file) == 1;
+		} else {
+			char path[4096];
+			snprintf(path, sizeof(path), exporter.pattern, (int)frame->frame);
+			Image image = {
+				.data = pixels,
+				.width = exporter.width,
+				.height = exporter.height,
+				.mipmaps = 1,
+				.format = PIXELFORMAT_UNCOMPRESSED_GRAYSCALE,
+			};
+			written = ExportImage(image, path);
+		}
+		exporter.busy[EXPORT_WRITING] += get_time() - begin;
+
+		queue_pop(&exporter.frames);
+		if (written == false) {
+			fprintf(stderr, "Couldn't write frame %llu.\n", (unsigned long long)frame->frame);
+			atomic_store(&exporter.failed, true);
+			break;
+		}
+	}
+
+	free(neutral);
+	atomic_store(&exporter.done[EXPORT_WRITING], true);
+	return NULL;
+}
+
+// Exports `frames` frames, one every `every` generations, with `scale` pixels per cell.
+static int
+run_export(const char *path, int frames, int every, int scale)
+{
+	if ((int64_t)scale * cell_count_w > 1 << 15 || (int64_t)scale * cell_count_h > 1 << 15) {
+		fprintf(stderr, "Frames of %lldx%lld pixels are too large.\n", (long long)(scale * cell_count_w), (long long)(scale * cell_count_h));
+		return 1;
+	}
+
+	size_t length = strlen(path);
+	exporter = (Exporter){
+		.path = path,
+		.y4m = length > 4 && strcmp(path + length - 4, ".y4m") == 0,
+		.scale = scale,
+		.width = (int)(scale * cell_count_w),
+		.height = (int)(scale * cell_count_h),
+		.word_count = delta_word_count(cell_count_w, cell_count_h),
+	};
+	if (exporter.y4m == false && export_pattern(path, exporter.pattern, sizeof(exporter.pattern)) == false) {
+		fprintf(stderr, "Invalid PNG pattern '%s': expected a path with at most one %%d or %%0<width>d (and %%%% for a '%%').\n", path);
+		return 1;
+	}
+	if (exporter.y4m) {
+		exporter.file = fopen(path, "wb");
+		if (exporter.file == NULL) {
+			fprintf(stderr, "Couldn't open '%s' for writing.\n", path);
+			return 1;
+		}
+		setvbuf(exporter.file, NULL, _IOFBF, 1 << 20);
+		fprintf(exporter.file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", exporter.width, exporter.height, EXPORT_FPS);
+	}
+
+	queue_init(&exporter.boards, EXPORT_QUEUE_SIZE, sizeof(ExportSlot) + exporter.word_count * 8);
+	queue_init(&exporter.frames, EXPORT_QUEUE_SIZE, sizeof(ExportSlot) + (size_t)exporter.width * exporter.height);
+	pthread_t threads[2];
+	pthread_create(&threads[0], NULL, export_rasterizer, NULL);
+	pthread_create(&threads[1], NULL, export_writer, NULL);
+
+	int mask = board_file.map ? board_file.header->mask : ALIVE_MASK_1;
+	if (board_file.map == NULL) {
+		init_cells((char)mask);
+	}
+	publish_step(mask, 0);
+
+	double begin = get_time();
+	uint64_t next = generation;
+	int frame = 0;
+	while (frame != frames && atomic_load(&exporter.failed) == false) {
+		double busy = get_time();
+		if (generation >= next) {
+			ExportSlot *slot;
+			while ((slot = queue_push_begin(&exporter.boards)) == NULL && atomic_load(&exporter.failed) == false) {
+				exporter.busy[EXPORT_SIMULATION] -= get_time() - busy;
+				sleep_ms(1);
+				busy = get_time();
+			}
+			if (slot == NULL) {
+				break;
+			}
+			slot->frame = (uint64_t)frame++;
+			pack_cells(mask, (uint64_t *)(slot + 1));
+			queue_push_end(&exporter.boards);
+			next = generation + (uint64_t)every;
+		}
+		if (frame != frames) {
+			int next_mask = mask == ALIVE_MASK_1 ? ALIVE_MASK_2 : ALIVE_MASK_1;
+			int gens = step_cells(mask, next_mask);
+			generation += gens;
+			publish_step(next_mask, gens);
+			mask = next_mask;
+		}
+		exporter.busy[EXPORT_SIMULATION] += get_time() - busy;
 	}
 
-	int size = cell_count_w * cell_count_h;
-	cells = malloc(size);
+	atomic_store(&exporter.done[EXPORT_SIMULATION], true);
+	pthread_join(threads[0], NULL);
+	pthread_join(threads[1], NULL);
+	double elapsed = get_time() - begin;
+	queue_free(&exporter.boards);
+	queue_free(&exporter.frames);
+	if (exporter.file && fclose(exporter.file) != 0) {
+		atomic_store(&exporter.failed, true);
+	}
+	if (atomic_load(&exporter.failed)) {
+		return 1;
+	}
+
+	printf("%d frame(s) of %dx%d pixels in %.3f s: %.1f frames/s, up to generation %llu\n", frame, exporter.width, exporter.height,
+		   elapsed, frame / elapsed, (unsigned long long)generation);
+	printf("Busy time: simulation %.3f s, rasterization %.3f s, writing %.3f s\n", exporter.busy[EXPORT_SIMULATION],
+		   exporter.busy[EXPORT_RASTERIZATION], exporter.busy[EXPORT_WRITING]);
+	return 0;
+}
+
+
+// Rendering: the board is drawn in a render texture that's kept from frame to frame, and only the tiles
+// flagged by the kernels are repainted in it, so that a settled board costs almost nothing to draw.
+//
+// Cell `x` covers the pixels `ceil(x * cell_size.x)` to `ceil((x + 1) * cell_size.x)`, so that the tiles
+// never overlap. When the board is larger than the window, most cells thus cover no pixel, and each pixel
+// shows the first cell that covers it.
+
+static RenderTexture2D canvas = { 0 };
+
+static int
+cell_to_pixel(int64_t cell, float size)
+{
+	double pixel = (double)cell * size;
+	return (int)pixel + (pixel > (double)(int)pixel ? 1 : 0);
+}
+
+// Repaints the dirty tiles in the canvas, and clears their flags.
+static void
+render_cells(int mask)
+{
+	BeginTextureMode(canvas);
+	for (int64_t tile_y = 0; tile_y != dirty_h; ++tile_y) {
+		uint8_t *dirty_row = &dirty[tile_y * dirty_w];
+		for (int64_t tile_x = 0; tile_x != dirty_w; ++tile_x) {
+			if ((dirty_row[tile_x] & DIRTY_REPAINT) == 0) {
+				continue;
+			}
+			dirty_row[tile_x] &= (uint8_t)~DIRTY_REPAINT;
+
+			int64_t x0 = tile_x << DIRTY_TILE_SHIFT;
+			int64_t y0 = tile_y << DIRTY_TILE_SHIFT;
+			int64_t x1 = x0 + (1 << DIRTY_TILE_SHIFT) < cell_count_w ? x0 + (1 << DIRTY_TILE_SHIFT) : cell_count_w;
+			int64_t y1 = y0 + (1 << DIRTY_TILE_SHIFT) < cell_count_h ? y0 + (1 << DIRTY_TILE_SHIFT) : cell_count_h;
+			int left = cell_to_pixel(x0, cell_size.x);
+			int top = cell_to_pixel(y0, cell_size.y);
+			DrawRectangle(left, top, cell_to_pixel(x1, cell_size.x) - left, cell_to_pixel(y1, cell_size.y) - top, DARKGRAY);
 
-	srand((uint32_t)time(0));
-	for (char *cell = cells, *end = cells + size; cell != end; ++cell) {
-		*cell = rand() < cell_prob ? alive : 0;
+			for (int64_t y = y0; y != y1; ++y) {
+				int py = cell_to_pixel(y, cell_size.y);
+				int height = cell_to_pixel(y + 1, cell_size.y) - py;
+				const char *row = &cells[y * cell_count_w];
+				for (int64_t x = x0; height != 0 && x != x1; ++x) {
+					if (row[x] & mask) {
+						int px = cell_to_pixel(x, cell_size.x);
+						int width = cell_to_pixel(x + 1, cell_size.x) - px;
+						if (width != 0) {
+							DrawRectangle(px, py, width, height, RAYWHITE);
+						}
+					}
+				}
+			}
+		}
 	}
+	EndTextureMode();
 }
 
 
 int
 main(int argc, char ** argv)
 {
-	(void)argc;
-	(void)argv;
+	int bench = 0;
+	const char *report = NULL;
+	const char *record = NULL;
+	const char *file = NULL;
+	const char *serve = NULL;
+	const char *export = NULL;
+	int export_frames = 300;
+	int export_every = 1;
+	int export_scale = 1;
+	bool rewind_option = false;
+	bool engine_option = false;
+	uint64_t census = 0;
+	bool check = false;
+	const char *check_cases_path = NULL;
+	const char *census_output = "census.txt";
+	int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+	// Command line. The `--bench` mode runs headless and is used by `nobs release-pgo` as its training
+	// and measurement workload.
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+			bench = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+			if (sscanf(argv[++i], "%" SCNd64 "x%" SCNd64, &cell_count_w, &cell_count_h) != 2 || cell_count_w <= 0 || cell_count_h <= 0) {
+				fprintf(stderr, "Invalid board size '%s', expected <width>x<height>.\n", argv[i]);
+				return 1;
+			}
+		} else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+			cell_seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--report") == 0 && i + 1 < argc) {
+			report = argv[++i];
+		} else if (strcmp(argv[i], "--block-gens") == 0 && i + 1 < argc) {
+			block_gens = atoi(argv[++i]);
+			if (block_gens < 1 || block_gens > BLOCK_MAX_GENS) {
+				fprintf(stderr, "Generations per block must be between 1 and %d.\n", BLOCK_MAX_GENS);
+				return 1;
+			}
+		} else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc) {
+			const char *name = argv[++i];
+			engine = strcmp(name, "all") == 0 ? -1 : find_engine(name);
+			if (engine < 0 && strcmp(name, "all") != 0) {
+				fprintf(stderr, "Unknown engine '%s'.\n", name);
+				return 1;
+			}
+			engine_option = true;
+		} else if (strcmp(argv[i], "--rule") == 0 && i + 1 < argc) {
+			if (rule_parse(argv[++i], &rule) == false) {
+				fprintf(stderr, "Invalid rule '%s', expected B<digits>/S<digits> or R<radius>,C0,M<0|1>,S<min>..<max>,B<min>..<max>,NM "
+								"(radius up to %d).\n", argv[i], LTL_MAX_RADIUS);
+				return 1;
+			}
+		} else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+			record = argv[++i];
+		} else if (strcmp(argv[i], "--keyframe-interval") == 0 && i + 1 < argc) {
+			keyframe_interval = strtoull(argv[++i], NULL, 10);
+			if (keyframe_interval == 0) {
+				fprintf(stderr, "The keyframe interval must be at least 1.\n");
+				return 1;
+			}
+		} else if (strcmp(argv[i], "--rewind-budget") == 0 && i + 1 < argc) {
+			rewind_budget = strtoull(argv[++i], NULL, 10) << 20;
+			rewind_option = true;
+		} else if (strcmp(argv[i], "--export") == 0 && i + 1 < argc) {
+			export = argv[++i];
+		} else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+			export_frames = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--export-every") == 0 && i + 1 < argc) {
+			export_every = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--export-scale") == 0 && i + 1 < argc) {
+			export_scale = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+			serve = argv[++i];
+		} else if (strcmp(argv[i], "--shm") == 0 && i + 1 < argc) {
+			shm_name = argv[++i];
+		} else if (strcmp(argv[i], "--file") == 0 && i + 1 < argc) {
+			file = argv[++i];
+		} else if (strcmp(argv[i], "--counters") == 0) {
+			counters_enabled = true;
+		} else if (strcmp(argv[i], "--huge-pages") == 0) {
+			huge_pages = true;
+		} else if (strcmp(argv[i], "--check") == 0) {
+			check = true;
+		} else if (strcmp(argv[i], "--check-cases") == 0 && i + 1 < argc) {
+			check_cases_path = argv[++i];
+		} else if (strcmp(argv[i], "--census") == 0 && i + 1 < argc) {
+			census = strtoull(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--census-output") == 0 && i + 1 < argc) {
+			census_output = argv[++i];
+		} else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			threads = atoi(argv[++i]);
+		} else {
+			fprintf(stderr, "Usage: %s [--engine <name>] [--rule B3/S23] [--block-gens <n>] [--rewind-budget <MB>]\n"
+							"          [--size <w>x<h>] [--huge-pages] [--file <board>] [--counters] [--threads <n>]\n"
+							"          [--record <file> [--keyframe-interval <n>]] [--shm <name>] [--serve <socket>]\n"
+							"          [--census <soups> [--census-output <file>] [--threads <n>] [--seed <n>]]\n"
+							"          [--check [--check-cases <file>]]\n"
+							"          [--export <file.y4m | pattern.png> [--frames <n>] [--export-every <n>] [--export-scale <n>] [--size <w>x<h>]]\n"
+							"          [--bench <generations> [--size <w>x<h>] [--seed <n>] [--report <file>]]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	init_rule();
+	scheduler_threads = threads > 0 ? threads : 1;
+
+	// Larger than Life rules run on the `ltl` engine, unless another one that supports them is asked for.
+	if (engine_option == false && rule.radius > 1) {
+		engine = find_engine("ltl");
+	} else if (engine >= 0 && engines[engine].max_radius < rule.radius) {
+		fprintf(stderr, "The %s engine only supports rules of radius %d.\n", engines[engine].name, engines[engine].max_radius);
+		return 1;
+	}
+
+	if (check) {
+		return run_check(check_cases_path);
+	}
+
+	if (census > 0) {
+		if (rule.radius > 1) {
+			fprintf(stderr, "The census only supports rules of radius 1.\n");
+			return 1;
+		}
+		return run_census(census, threads > 0 ? threads : 1, census_output);
+	}
+
+	// An out-of-core board is larger than the rewind buffer anyway.
+	int file_mask = ALIVE_MASK_1;
+	if (file) {
+		rewind_budget = rewind_option ? rewind_budget : 0;
+		if ((file_mask = board_file_open(file)) == 0) {
+			return 1;
+		}
+	}
+
+	if (serve && server_start(serve) == false) {
+		return 1;
+	}
+
+	if (export) {
+		if (export_frames <= 0 || export_every <= 0 || export_scale <= 0) {
+			fprintf(stderr, "The number of frames, the interval and the scale of the export must be positive.\n");
+			return 1;
+		}
+		rewind_budget = rewind_option ? rewind_budget : 0;
+		if (engine < 0) {
+			engine = 0;
+		}
+		if (cell_count_w == 0) {
+			cell_count_w = 1024;
+			cell_count_h = 1024;
+		}
+		if (record && recording_start(record) == false) {
+			return 1;
+		}
+		int result = run_export(export, export_frames, export_every, export_scale);
+		recording_stop();
+		board_file_close();
+		shm_close();
+		server_stop();
+		return result;
+	}
+
+	if (bench > 0) {
+		// The rewind buffer is only useful interactively, unless explicitly requested.
+		rewind_budget = rewind_option ? rewind_budget : 0;
+		if (cell_count_w == 0) {
+			cell_count_w = 1024;
+			cell_count_h = 1024;
+		}
+		if (record && recording_start(record) == false) {
+			return 1;
+		}
+		int result = run_benchmark(bench, report);
+		recording_stop();
+		board_file_close();
+		shm_close();
+		server_stop();
+		return result;
+	}
+
+	if (engine < 0) {
+		engine = 0;
+	}
+
+	// Without `--size`, the board follows the size of the window.
+	bool fixed_size = cell_count_w != 0;
 
 	InitWindow(800, 500, "Game of Life.");
 	SetWindowState(FLAG_WINDOW_RESIZABLE | FLAG_WINDOW_HIGHDPI);
@@ -57,7 +3690,8 @@ main(int argc, char ** argv)
 	bool paused = false;
 	int previous_w = 0;
 	int previous_h = 0;
-	int mask = ALIVE_MASK_1;
+	int mask = file_mask;
+	uint64_t rewind_speed = 1;
 
 	// Enter the main app loop.
 	while (WindowShouldClose() == false) {
@@ -66,7 +3700,7 @@ main(int argc, char ** argv)
 		// Events.
 
 		if (IsKeyPressed(KEY_R)) {
-			init_cells((char)mask);
+			reset_board(mask);
 		}
 		if (IsKeyPressed(KEY_H)) {
 			hud = !hud;
@@ -74,7 +3708,37 @@ main(int argc, char ** argv)
 		if (IsKeyPressed(KEY_SPACE)) {
 			paused = !paused;
 		}
+
+		// Rewind: holding backspace scrubs backwards, faster and faster. Left / right then step through the history.
+		if (IsKeyDown(KEY_BACKSPACE) && rewind_buffer.cursor != 0) {
+			paused = true;
+			rewind_to(mask, rewind_buffer.cursor > rewind_speed ? rewind_buffer.cursor - rewind_speed : 0);
+			rewind_speed = rewind_speed < 256 ? rewind_speed * 2 : rewind_speed;
+		} else {
+			rewind_speed = 1;
+		}
+		if (paused && IsKeyPressed(KEY_LEFT) && rewind_buffer.cursor != 0) {
+			rewind_to(mask, rewind_buffer.cursor - 1);
+		}
+		if (paused && IsKeyPressed(KEY_RIGHT) && rewind_buffer.cursor != rewind_buffer.count) {
+			rewind_to(mask, rewind_buffer.cursor + 1);
+		}
+		if (IsKeyPressed(KEY_G)) {
+			block_gens = block_gens >= BLOCK_MAX_GENS ? 1 : block_gens * 2;
+		}
+		if (IsKeyPressed(KEY_E)) {
+			do {
+				engine = (engine + 1) % ENGINE_COUNT;
+			} while (engines[engine].max_radius < rule.radius);
+		}
+		if (IsKeyPressed(KEY_C)) {
+			counters_enabled = !counters_enabled;
+		}
 		if (IsKeyPressed(KEY_ESCAPE)) {
+			recording_stop();
+			board_file_close();
+			shm_close();
+			server_stop();
 			exit(0);
 		}
 
@@ -82,36 +3746,75 @@ main(int argc, char ** argv)
 
 		int w = GetRenderWidth();
 		int h = GetRenderHeight();
-		if (cells == NULL || previous_w != w || previous_h != h) {
+		if (previous_w == 0 || (fixed_size == false && (previous_w != w || previous_h != h))) {
 			previous_w = w;
 			previous_h = h;
-			cell_count_w = w / cell_target_size;
-			cell_count_h = h / cell_target_size;
-			cell_size.x = (float)w / cell_count_w;
-			cell_size.y = (float)h / cell_count_h;
-			init_cells((char)mask);
-		}
-
-		// Clear screen.
-
-		ClearBackground(DARKGRAY);
+			if (fixed_size == false) {
+				cell_count_w = w / cell_target_size;
+				cell_count_h = h / cell_target_size;
+			}
+			if (board_file.map == NULL) {
+				init_cells((char)mask);
+			}
 
-		BeginMode2D((Camera2D){ .zoom = 1.0f });
+			// A recording has a fixed size, so it ends when the board is resized.
+			if (recording) {
+				printf("Board resized, recording stopped.\n");
+				recording_stop();
+			} else if (record) {
+				recording_start(record);
+				record = NULL;
+			}
+			publish_step(mask, 0);
+		}
+		cell_size.x = (float)w / cell_count_w;
+		cell_size.y = (float)h / cell_count_h;
 
-		// Draw cells.
+		// Draw cells: repaint what changed in the canvas (all of it when the window is resized), and present it.
+		// Render textures are upside down.
 
-		for (int y = 0; y != cell_count_h; ++y) {
-			for (int x = 0; x != cell_count_w; ++x) {
-				if (cells[y * cell_count_w + x] & mask) {
-					DrawRectangleV((Vector2){ x * cell_size.x, y * cell_size.y }, cell_size, RAYWHITE);
-				}
+		if (canvas.texture.width != w || canvas.texture.height != h) {
+			if (canvas.id != 0) {
+				UnloadRenderTexture(canvas);
 			}
+			canvas = LoadRenderTexture(w, h);
+			BeginTextureMode(canvas);
+			ClearBackground(DARKGRAY);
+			EndTextureMode();
+			init_dirty();
 		}
+		render_cells(mask);
+		DrawTextureRec(canvas.texture, (Rectangle){ 0.0f, 0.0f, (float)w, -(float)h }, (Vector2){ 0.0f, 0.0f }, WHITE);
+
+		BeginMode2D((Camera2D){ .zoom = 1.0f });
 
 		// Draw HUD
 
 		if (hud) {
-			DrawText("Hello", 10, 10, 30, BLACK);
+			DrawText(TextFormat("%lld x %lld cells, rule %s, engine %s, %d generation(s) per block", (long long)cell_count_w, (long long)cell_count_h, rule_to_string(),
+								engines[engine].name, block_gens), 10, 10, 20, BLACK);
+			DrawText(TextFormat("Generation %llu, %llu step(s) of history, %.1f / %.1f MB", (unsigned long long)generation,
+								(unsigned long long)rewind_buffer.count, (double)(rewind_buffer.data_end - rewind_buffer.data_begin) / (1 << 20),
+								(double)rewind_buffer.data_size / (1 << 20)), 10, 35, 20, BLACK);
+			char stats[256];
+			MemoryStats memory = read_memory_stats();
+			format_memory_stats(&memory, stats, sizeof(stats));
+			DrawText(stats, 10, 60, 20, BLACK);
+			int y = 85;
+			if (counters_enabled) {
+				format_counters(&counters_last, stats, sizeof(stats));
+				DrawText(stats, 10, y, 20, BLACK);
+				y += 25;
+			}
+			if (board_file.map == NULL) {
+				format_scheduler_stats(&scheduler_last, stats, sizeof(stats));
+				DrawText(stats, 10, y, 20, BLACK);
+				y += 25;
+			}
+			if (recording) {
+				DrawText(TextFormat("Recording: generation %llu, %.1f MB written, %d step(s) queued", (unsigned long long)recorder.generation,
+									(double)atomic_load(&recorder.bytes_written) / (1 << 20), (int)queue_count(&recorder.queue)), 10, y, 20, BLACK);
+			}
 		}
 
 		EndMode2D();
@@ -121,37 +3824,9 @@ main(int argc, char ** argv)
 			// Update the cells.
 
 			int next_mask = mask == ALIVE_MASK_1 ? ALIVE_MASK_2 : ALIVE_MASK_1;
-
-			for (int y = 0; y != cell_count_h; ++y) {
-				for (int x = 0; x != cell_count_w; ++x) {
-					int neighbors = ((CELL(x - 1, y - 1) & mask) ? 1 : 0) +
-									((CELL(x,     y - 1) & mask) ? 1 : 0) +
-									((CELL(x + 1, y - 1) & mask) ? 1 : 0) +
-									((CELL(x - 1, y    ) & mask) ? 1 : 0) +
-									((CELL(x + 1, y    ) & mask) ? 1 : 0) +
-									((CELL(x - 1, y + 1) & mask) ? 1 : 0) +
-									((CELL(x,     y + 1) & mask) ? 1 : 0) +
-									((CELL(x + 1, y + 1) & mask) ? 1 : 0);
-
-					char *cell = &CELL(x, y);
-					switch (neighbors) {
-						case 0:
-						case 1:
-							*cell &= ~next_mask;
-							break;
-						case 2:
-							*cell = (*cell & mask) ? *cell | (char)next_mask : *cell & ~(char)next_mask;
-							break;
-						case 3:
-							*cell |= next_mask;
-							break;
-						default:
-							*cell &= ~next_mask;
-							break;
-					}
-				}
-			}
-
+			int gens = step_cells(mask, next_mask);
+			generation += gens;
+			publish_step(next_mask, gens);
 			mask = next_mask;
 
 		}
@@ -159,5 +3834,9 @@ main(int argc, char ** argv)
 		EndDrawing();
 	}
 
+	recording_stop();
+	board_file_close();
+	shm_close();
+	server_stop();
 	return 0;
 }
@@ -0,0 +1,211 @@
+#include "gol.h"
+#include "delta.h"
+#include "ltl.h"
+#include "rule.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+// Implementation of the simulation library (see gol.h).
+//
+// Boards have the layout of the game's board, and are stepped by the game's ltl kernel (see ltl.h), which costs
+// the same for any radius: each cell is a byte holding its state in 2 generations, in the bits `GOL_ALIVE_1` and
+// `GOL_ALIVE_2`, and `mask` is the bit of the current generation. `next` maps the state of a cell and the sum of
+// its neighborhood to its next state (see `rule_sum_table`).
+
+
+#define GOL_ALIVE_1	(1 << 7)
+#define GOL_ALIVE_2	(1 << 6)
+
+struct GolBoard {
+	int64_t		width;
+	int64_t		height;
+	uint64_t	generation;
+	Rule		rule;
+	uint8_t		next[2][LTL_MAX_COUNT + 1];
+	char *		cells;
+	int			mask;
+	LtlScratch	scratch;
+};
+
+
+static inline int64_t
+mod(int64_t a, int64_t b)
+{
+	int64_t r = a % b;
+	return r < 0 ? r + b : r;
+}
+
+static void
+step_board(GolBoard *board)
+{
+	LtlBoard ltl = {
+		.cells = board->cells,
+		.width = board->width,
+		.height = board->height,
+		.radius = board->rule.radius,
+		.next = (const uint8_t (*)[LTL_MAX_COUNT + 1])board->next,
+	};
+	int next_mask = board->mask ^ (GOL_ALIVE_1 | GOL_ALIVE_2);
+	ltl_step(&ltl, &board->scratch, board->mask, next_mask, 0, board->width, 0, board->height);
+	board->mask = next_mask;
+	++board->generation;
+}
+
+
+int
+gol_version(void)
+{
+	return GOL_VERSION;
+}
+
+GolBoard *
+gol_board_create(int64_t width, int64_t height)
+{
+	if (width <= 0 || height <= 0 || width > INT32_MAX || height > INT32_MAX) {
+		return NULL;
+	}
+	if ((uint64_t)width > SIZE_MAX / (uint64_t)height) {
+		return NULL;
+	}
+
+	GolBoard *board = calloc(1, sizeof(GolBoard));
+	if (board == NULL) {
+		return NULL;
+	}
+	board->width = width;
+	board->height = height;
+	board->rule = (Rule)RULE_CONWAY;
+	rule_sum_table(&board->rule, board->next);
+	board->cells = calloc((size_t)(width * height), 1);
+	board->mask = GOL_ALIVE_1;
+
+	// The buffers of the kernel are allocated for the largest radius, so that stepping never allocates.
+	int64_t span = width + 2 * LTL_MAX_RADIUS;
+	board->scratch.columns = malloc((size_t)span * sizeof(int64_t));
+	board->scratch.sums = malloc((size_t)span);
+	board->scratch.capacity = span;
+	if (board->cells == NULL || board->scratch.columns == NULL || board->scratch.sums == NULL) {
+		gol_board_destroy(board);
+		return NULL;
+	}
+	return board;
+}
+
+void
+gol_board_destroy(GolBoard *board)
+{
+	if (board != NULL) {
+		free(board->cells);
+		ltl_scratch_free(&board->scratch);
+		free(board);
+	}
+}
+
+bool
+gol_board_set_rule(GolBoard *board, const char *rule)
+{
+	if (rule_parse(rule, &board->rule) == false) {
+		return false;
+	}
+	rule_sum_table(&board->rule, board->next);
+	return true;
+}
+
+char *
+gol_board_get_rule(const GolBoard *board, char *out, size_t size)
+{
+	return rule_format(&board->rule, out, size);
+}
+
+int64_t
+gol_board_width(const GolBoard *board)
+{
+	return board->width;
+}
+
+int64_t
+gol_board_height(const GolBoard *board)
+{
+	return board->height;
+}
+
+uint64_t
+gol_board_generation(const GolBoard *board)
+{
+	return board->generation;
+}
+
+uint64_t
+gol_board_population(const GolBoard *board)
+{
+	uint64_t population = 0;
+	for (int64_t i = 0; i != board->width * board->height; ++i) {
+		population += (board->cells[i] & board->mask) != 0;
+	}
+	return population;
+}
+
+void
+gol_board_step(GolBoard *board)
+{
+	step_board(board);
+}
+
+void
+gol_board_step_n(GolBoard *board, uint64_t count)
+{
+	for (uint64_t i = 0; i != count; ++i) {
+		step_board(board);
+	}
+}
+
+size_t
+gol_packed_word_count(int64_t width, int64_t height)
+{
+	return delta_word_count((size_t)width, (size_t)height);
+}
+
+void
+gol_board_import_packed(GolBoard *board, const uint64_t *words)
+{
+	for (int64_t i = 0; i != board->width * board->height; ++i) {
+		board->cells[i] = (char)(((words[i / 64] >> (i % 64)) & 1) ? board->mask : 0);
+	}
+}
+
+void
+gol_board_export_packed(const GolBoard *board, uint64_t *words)
+{
+	memset(words, 0, gol_packed_word_count(board->width, board->height) * 8);
+	for (int64_t i = 0; i != board->width * board->height; ++i) {
+		words[i / 64] |= (uint64_t)((board->cells[i] & board->mask) != 0) << (i % 64);
+	}
+}
+
+bool
+gol_board_get_cell(const GolBoard *board, int64_t x, int64_t y)
+{
+	return (board->cells[mod(y, board->height) * board->width + mod(x, board->width)] & board->mask) != 0;
+}
+
+void
+gol_board_set_cell(GolBoard *board, int64_t x, int64_t y, bool alive)
+{
+	char *cell = &board->cells[mod(y, board->height) * board->width + mod(x, board->width)];
+	*cell = (char)((*cell & ~board->mask) | (alive ? board->mask : 0));
+}
+
+void
+gol_board_randomize(GolBoard *board, double density, uint64_t seed)
+{
+	// Splitmix64, so that boards don't share the state of `rand`.
+	for (int64_t i = 0; i != board->width * board->height; ++i) {
+		uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		z ^= z >> 31;
+		board->cells[i] = (char)((double)(z >> 11) * 0x1.0p-53 < density ? board->mask : 0);
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+// Simulation library: the Game of Life and its Larger than Life variants on toroidal boards, without Raylib
+// and without any global state, for tools that need the simulation without the game (built by nobs.c as
+// `build/libs/libgol`).
+//
+// Boards are opaque handles. Each board has its own cells, rule and buffers, so different boards can be used at
+// the same time from different threads, but a board must not be used by 2 threads at once.
+//
+// Cells are imported and exported as packed boards: arrays of `gol_packed_word_count` 64 bits words, cell `i`
+// (row major, so `y * width + x`) being bit `i % 64` of word `i / 64`. This is the layout of the recordings,
+// shared memory exports and streams of the game (see delta.h), and the bits past the last cell are zero.
+//
+// Rules are strings in the B/S notation (e.g. "B3/S23") or the Larger than Life one of Golly (e.g.
+// "R5,C0,M1,S34..58,B34..45,NM", see rule.h), the same as the game's `--rule`.
+//
+// The API is stable: functions are only added, and `GOL_VERSION` is incremented when they are.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+#define GOL_VERSION	1
+
+typedef struct GolBoard GolBoard;
+
+
+// Version of the library, `GOL_VERSION` of the header it was built with.
+int gol_version(void);
+
+// Creates an empty board of `width` x `height` cells, with Conway's rule. Each dimension must be between 1 and
+// INT32_MAX: returns NULL otherwise, or if the memory can't be allocated.
+GolBoard *gol_board_create(int64_t width, int64_t height);
+
+// Destroys `board`. Does nothing with NULL.
+void gol_board_destroy(GolBoard *board);
+
+// Sets the rule of `board`. Returns false and keeps the current rule if `rule` isn't valid.
+bool gol_board_set_rule(GolBoard *board, const char *rule);
+
+// Formats the rule of `board` into `out` (64 bytes are always enough), and returns `out`.
+char *gol_board_get_rule(const GolBoard *board, char *out, size_t size);
+
+int64_t gol_board_width(const GolBoard *board);
+int64_t gol_board_height(const GolBoard *board);
+
+// Number of generations computed since the board was created.
+uint64_t gol_board_generation(const GolBoard *board);
+
+// Number of live cells.
+uint64_t gol_board_population(const GolBoard *board);
+
+// Computes the next generation.
+void gol_board_step(GolBoard *board);
+
+// Computes the next `count` generations.
+void gol_board_step_n(GolBoard *board, uint64_t count);
+
+// Number of words of a packed board of `width` x `height` cells.
+size_t gol_packed_word_count(int64_t width, int64_t height);
+
+// Replaces the cells of `board` with the packed board `words`, of the size of `board`.
+void gol_board_import_packed(GolBoard *board, const uint64_t *words);
+
+// Writes the cells of `board` into the packed board `words`, of the size of `board`.
+void gol_board_export_packed(const GolBoard *board, uint64_t *words);
+
+// State of a single cell. Coordinates wrap around the board.
+bool gol_board_get_cell(const GolBoard *board, int64_t x, int64_t y);
+void gol_board_set_cell(GolBoard *board, int64_t x, int64_t y, bool alive);
+
+// Replaces the cells of `board` with random ones, each alive with the probability `density` (0 to 1). The same
+// seed always gives the same cells.
+void gol_board_randomize(GolBoard *board, double density, uint64_t seed);
@@ -0,0 +1,128 @@
+#include "gol.h"
+#include "delta.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+
+// Batch runner built on the simulation library (see gol.h), and example of its use.
+//
+// Runs `--boards` random boards at once, each on its own thread, for `--gens` generations, and prints the
+// population and hash of each of them. Board `i` is seeded with `--seed` + i, so runs can be reproduced. The hash
+// is the same as the game's `hash_cells`, `shm_reader`'s and the player's `--dump`.
+
+
+typedef struct {
+	pthread_t	thread;
+	GolBoard *	board;
+	uint64_t	gens;
+	double		seconds;
+} Job;
+
+
+static double
+get_time(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+// Hash of the cells of `board` (see `delta_hash_cells`).
+static uint64_t
+hash_board(const GolBoard *board)
+{
+	size_t size = (size_t)(gol_board_width(board) * gol_board_height(board));
+	uint64_t *words = malloc(gol_packed_word_count(gol_board_width(board), gol_board_height(board)) * 8);
+	gol_board_export_packed(board, words);
+	uint64_t hash = delta_hash_cells(words, size);
+	free(words);
+	return hash;
+}
+
+static void *
+run_job(void *data)
+{
+	Job *job = data;
+	double begin = get_time();
+	gol_board_step_n(job->board, job->gens);
+	job->seconds = get_time() - begin;
+	return NULL;
+}
+
+
+int
+main(int argc, char ** argv)
+{
+	int boards = 4;
+	long long width = 512, height = 512;
+	uint64_t gens = 100, seed = 1;
+	double density = 0.5;
+	const char *rule = "B3/S23";
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--boards") == 0 && i + 1 < argc) {
+			boards = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+			if (sscanf(argv[++i], "%lldx%lld", &width, &height) != 2) {
+				argc = 0;
+			}
+		} else if (strcmp(argv[i], "--gens") == 0 && i + 1 < argc) {
+			gens = strtoull(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+			seed = strtoull(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--density") == 0 && i + 1 < argc) {
+			density = atof(argv[++i]) / 100.0;
+		} else if (strcmp(argv[i], "--rule") == 0 && i + 1 < argc) {
+			rule = argv[++i];
+		} else {
+			argc = 0;
+		}
+	}
+	if (argc == 0 || boards < 1) {
+		fprintf(stderr, "Usage: %s [--boards <n>] [--size <w>x<h>] [--gens <n>] [--seed <n>] [--density <percent>] [--rule <rule>]\n",
+				argv[0]);
+		return 1;
+	}
+
+	Job *jobs = calloc((size_t)boards, sizeof(Job));
+	for (int i = 0; i != boards; ++i) {
+		jobs[i].board = gol_board_create(width, height);
+		if (jobs[i].board == NULL) {
+			fprintf(stderr, "Couldn't create a %lldx%lld board.\n", width, height);
+			return 1;
+		}
+		if (gol_board_set_rule(jobs[i].board, rule) == false) {
+			fprintf(stderr, "Invalid rule '%s'.\n", rule);
+			return 1;
+		}
+		gol_board_randomize(jobs[i].board, density, seed + (uint64_t)i);
+		jobs[i].gens = gens;
+	}
+
+	double begin = get_time();
+	for (int i = 0; i != boards; ++i) {
+		pthread_create(&jobs[i].thread, NULL, run_job, &jobs[i]);
+	}
+	for (int i = 0; i != boards; ++i) {
+		pthread_join(jobs[i].thread, NULL);
+	}
+	double seconds = get_time() - begin;
+
+	char text[64];
+	printf("%d board(s) of %lldx%lld cells, rule %s, library version %d\n", boards, width, height,
+		   gol_board_get_rule(jobs[0].board, text, sizeof(text)), gol_version());
+	for (int i = 0; i != boards; ++i) {
+		printf("board %d: seed %llu, generation %llu, population %llu, hash %016llx, %.2f Mcells/s\n", i,
+			   (unsigned long long)(seed + (uint64_t)i), (unsigned long long)gol_board_generation(jobs[i].board),
+			   (unsigned long long)gol_board_population(jobs[i].board), (unsigned long long)hash_board(jobs[i].board),
+			   (double)width * height * gens / jobs[i].seconds / 1e6);
+		gol_board_destroy(jobs[i].board);
+	}
+	printf("%.3f s, %.2f Mcells/s in total\n", seconds, (double)width * height * gens * boards / seconds / 1e6);
+	free(jobs);
+	return 0;
+}
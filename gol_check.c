@@ -0,0 +1,80 @@
+#include "gol.h"
+#include "delta.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+
+// Conformance check of the simulation library (see gol.h) against the game's reference engine.
+//
+// Reads the cases written by `game_of_life --check --check-cases <file>`: the same rules, sizes, patterns
+// and seeds as the game's `--check`, each with its initial board and the hash of every generation stepped by
+// the reference engine. Every case is run through the library's API, one generation at a time, and its hash
+// compared to the reference's. The hash is the same as the game's `hash_cells` (see delta.h).
+
+
+int
+main(int argc, char ** argv)
+{
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s <cases>\n", argv[0]);
+		return 1;
+	}
+	FILE *file = fopen(argv[1], "r");
+	if (file == NULL) {
+		fprintf(stderr, "Couldn't open '%s'.\n", argv[1]);
+		return 1;
+	}
+
+	int cases = 0, failures = 0;
+	char name[64], rule[64];
+	long long width, height;
+	int generations;
+	while (fscanf(file, "%63s %63s %lld %lld %d", name, rule, &width, &height, &generations) == 5) {
+		GolBoard *board = gol_board_create(width, height);
+		if (board == NULL || gol_board_set_rule(board, rule) == false || generations < 0) {
+			fprintf(stderr, "Invalid case %d (%s, %lldx%lld, rule %s).\n", cases + 1, name, width, height, rule);
+			return 1;
+		}
+
+		size_t word_count = gol_packed_word_count(width, height);
+		uint64_t *words = malloc(word_count * 8);
+		for (size_t i = 0; i != word_count; ++i) {
+			unsigned long long word;
+			if (fscanf(file, "%llx", &word) != 1) {
+				fprintf(stderr, "Truncated case %d.\n", cases + 1);
+				return 1;
+			}
+			words[i] = word;
+		}
+		gol_board_import_packed(board, words);
+
+		for (int generation = 0; generation <= generations; ++generation) {
+			unsigned long long expected;
+			if (fscanf(file, "%llx", &expected) != 1) {
+				fprintf(stderr, "Truncated case %d.\n", cases + 1);
+				return 1;
+			}
+			if (generation != 0) {
+				gol_board_step(board);
+			}
+			gol_board_export_packed(board, words);
+			if (delta_hash_cells(words, (size_t)(width * height)) != expected) {
+				printf("FAIL libgol     %s, %lldx%lld, rule %s: differs at generation %d\n", name, width, height, rule, generation);
+				++failures;
+				// Skip the hashes of the following generations.
+				fscanf(file, "%*[^\n]");
+				break;
+			}
+		}
+
+		free(words);
+		gol_board_destroy(board);
+		++cases;
+	}
+	fclose(file);
+
+	printf("%d case(s) through the library: %d failure(s)\n", cases, failures);
+	return failures || cases == 0 ? 1 : 0;
+}
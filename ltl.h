@@ -0,0 +1,167 @@
+#pragma once
+
+// Larger than Life kernel, shared by the game's ltl engine and the library (see gol.h): computes the next
+// generation of a rule of any radius R (see rule.h), in constant time per cell.
+//
+// Boards have the game's layout: one byte per cell, row major, wrapping around on both sides. Each cell holds
+// its state in 2 generations in 2 of its bits, so the kernel reads the `mask` bit of the cells and writes their
+// `next_mask` bit, and a board can be stepped in several ranges (on several threads) without any copy.
+//
+// Each column of the range (and of the R columns on each side) keeps the sum of its 2R + 1 cells around the
+// current row, which slides to the next row by adding the cell that enters it and subtracting the one that
+// leaves it. These sums fit in a byte, so they are updated 8 at a time in 64 bits words, each byte staying
+// between 0 and 2R + 2 without any carry to the next one. The neighborhood sum of a cell then slides along the
+// row the same way, by adding the column sum that enters it and subtracting the one that leaves it.
+
+#include "rule.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// Board stepped by `ltl_step`. `next` maps the state of a cell and the sum of its neighborhood to its next state
+// (see `rule_sum_table`). When `dirty` isn't NULL, `dirty_flags` are set in the tiles of 2^dirty_shift x
+// 2^dirty_shift cells (`dirty_w` per row) where a cell changed.
+typedef struct {
+	char *			cells;
+	int64_t			width;
+	int64_t			height;
+	int				radius;
+	const uint8_t	(*next)[LTL_MAX_COUNT + 1];
+	uint8_t *		dirty;
+	int64_t			dirty_w;
+	int				dirty_shift;
+	uint8_t			dirty_flags;
+} LtlBoard;
+
+// Buffers of `ltl_step`, grown as needed. A thread stepping a board needs its own.
+typedef struct {
+	int64_t *	columns;
+	uint8_t *	sums;
+	int64_t		capacity;
+} LtlScratch;
+
+
+static inline void
+ltl_scratch_free(LtlScratch *scratch)
+{
+	free(scratch->columns);
+	free(scratch->sums);
+	*scratch = (LtlScratch){ 0 };
+}
+
+// Row `y` of `board`, wrapped around.
+static inline uint8_t *
+ltl_row(const LtlBoard *board, int64_t y)
+{
+	y %= board->height;
+	return (uint8_t *)board->cells + (y < 0 ? y + board->height : y) * board->width;
+}
+
+// Steps the columns `x_begin` to `x_end` of the rows `y_begin` to `y_end` of `board`. Returns false if the
+// buffers of `scratch` couldn't be allocated.
+static inline bool
+ltl_step(const LtlBoard *board, LtlScratch *scratch, int mask, int next_mask, int64_t x_begin, int64_t x_end, int64_t y_begin,
+		 int64_t y_end)
+{
+	int r = board->radius;
+	int64_t n = x_end - x_begin;
+	int64_t span = n + 2 * r;
+	if (n <= 0 || y_begin >= y_end) {
+		return true;
+	}
+	if (scratch->capacity < span) {
+		ltl_scratch_free(scratch);
+		scratch->columns = malloc(span * sizeof(int64_t));
+		scratch->sums = malloc(span);
+		if (scratch->columns == NULL || scratch->sums == NULL) {
+			ltl_scratch_free(scratch);
+			return false;
+		}
+		scratch->capacity = span;
+	}
+	int64_t *columns = scratch->columns;
+	uint8_t *sums = scratch->sums;
+	const uint8_t (*next_state)[LTL_MAX_COUNT + 1] = board->next;
+
+	// The columns of the window wrap around the board, several times if it's narrower than the window.
+	int shift = 0;
+	while ((mask >> shift) != 1) {
+		++shift;
+	}
+	for (int64_t i = 0; i != span; ++i) {
+		int64_t x = (x_begin - r + i) % board->width;
+		columns[i] = x < 0 ? x + board->width : x;
+	}
+	memset(sums, 0, span);
+	for (int64_t y = y_begin - r; y <= y_begin + r; ++y) {
+		const uint8_t *row = ltl_row(board, y);
+		for (int64_t i = 0; i != span; ++i) {
+			sums[i] += (row[columns[i]] >> shift) & 1;
+		}
+	}
+
+	for (int64_t y = y_begin; y != y_end; ++y) {
+		if (y != y_begin) {
+			const uint8_t *in = ltl_row(board, y + r);
+			const uint8_t *out = ltl_row(board, y - r - 1);
+			for (int64_t i = 0; i != r; ++i) {
+				sums[i] += ((in[columns[i]] >> shift) & 1) - ((out[columns[i]] >> shift) & 1);
+				sums[n + r + i] += ((in[columns[n + r + i]] >> shift) & 1) - ((out[columns[n + r + i]] >> shift) & 1);
+			}
+
+			uint8_t *middle = sums + r;
+			int64_t i = 0;
+			for (; i + 8 <= n; i += 8) {
+				uint64_t enter, leave, sum;
+				memcpy(&enter, in + x_begin + i, 8);
+				memcpy(&leave, out + x_begin + i, 8);
+				memcpy(&sum, middle + i, 8);
+				sum = sum + ((enter >> shift) & 0x0101010101010101ull) - ((leave >> shift) & 0x0101010101010101ull);
+				memcpy(middle + i, &sum, 8);
+			}
+			for (; i != n; ++i) {
+				middle[i] += ((in[x_begin + i] >> shift) & 1) - ((out[x_begin + i] >> shift) & 1);
+			}
+		}
+
+		int sum = 0;
+		for (int64_t i = 0; i != 2 * r; ++i) {
+			sum += sums[i];
+		}
+		// Cells are loaded and stored through locals: stores through `char` pointers could alias everything else.
+		char *row = &board->cells[y * board->width + x_begin];
+		const uint8_t *entering = sums + 2 * r;
+		if (board->dirty == NULL) {
+			for (int64_t i = 0; i != n; ++i) {
+				uint8_t cell = (uint8_t)row[i];
+				sum += entering[i];
+				cell = (uint8_t)((cell & ~next_mask) | (next_state[(cell >> shift) & 1][sum] * next_mask));
+				sum -= sums[i];
+				row[i] = (char)cell;
+			}
+			continue;
+		}
+
+		// The changes are gathered per dirty tile.
+		uint8_t *dirty_row = &board->dirty[(y >> board->dirty_shift) * board->dirty_w];
+		for (int64_t i = 0; i != n;) {
+			int64_t tile_end = ((((x_begin + i) >> board->dirty_shift) + 1) << board->dirty_shift) - x_begin;
+			int changed = 0;
+			for (int64_t end = tile_end < n ? tile_end : n; i != end; ++i) {
+				uint8_t cell = (uint8_t)row[i];
+				sum += entering[i];
+				int alive = (cell >> shift) & 1;
+				int next = next_state[alive][sum];
+				cell = (uint8_t)((cell & ~next_mask) | (next * next_mask));
+				changed |= alive ^ next;
+				sum -= sums[i];
+				row[i] = (char)cell;
+			}
+			dirty_row[(x_begin + i - 1) >> board->dirty_shift] |= (uint8_t)(changed * board->dirty_flags);
+		}
+	}
+	return true;
+}
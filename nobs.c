@@ -6,6 +6,288 @@
 #	include "./config.h"
 #endif
 
+// The game and its tools use POSIX threads, shared memory, sockets and memory maps.
+#if NOBS_WINDOWS
+#	error "Windows isn't supported: the game and its tools build on POSIX systems (Linux, macOS, BSD)."
+#endif
+
+
+#ifdef CONFIGURED
+
+// Fixed headless workloads used by `nobs release-pgo`. The training run drives the instrumented
+// build, the measurement run is executed on both the plain and the optimized builds.
+#define PGO_TRAINING_ARGS	"--bench", "60", "--size", "1024x1024", "--seed", "1", "--engine", "all"
+#define PGO_MEASURE_ARGS	"--bench", "400", "--size", "1024x1024", "--seed", "2", "--engine", "all"
+
+// Workload and stored baseline of the performance regression gate of `nobs test`.
+#define TEST_BENCH_ARGS		"--bench", "200", "--size", "512x512", "--seed", "3", "--engine", "all"
+#define TEST_BASELINE		"./build/perf_baseline.txt"
+#define TEST_TOLERANCE		10.0
+
+#define LIB_EXT				".a"
+
+
+// Builds Raylib in `libs_dir` and `source` as `output`, using `arguments` for both.
+static int
+build_program(NobsString source, NobsString output, NobsString libs_dir, NobsArray arguments)
+{
+	nobs_file_make_dirs(libs_dir);
+
+	NobsArray raylib = nobs_raylib(RAYLIB_DIR, libs_dir, arguments);
+
+	arguments = nobs_array_copy(arguments);
+	nobs_array_append(&arguments, "-Wall", "-pthread");
+
+	NobsArray command = { 0 };
+	nobs_array_append(&command, NOBS_COMPILER, NOBS_OUT_EXE(output), source);
+	nobs_array_merge(&command, arguments, raylib);
+	return nobs_proc_run_sync(command);
+}
+
+// Builds `source`, which doesn't use Raylib, as `output`.
+static int
+build_tool(NobsString source, NobsString output, NobsArray arguments)
+{
+	arguments = nobs_array_copy(arguments);
+	nobs_array_append(&arguments, "-Wall", "-pthread");
+
+	NobsArray command = { 0 };
+	nobs_array_append(&command, NOBS_COMPILER, NOBS_OUT_EXE(output), source);
+	nobs_array_merge(&command, arguments);
+	return nobs_proc_run_sync(command);
+}
+
+// Builds `source`, which doesn't use Raylib, as the static library `output` (without its extension).
+static int
+build_library(NobsString source, NobsString output, NobsArray arguments)
+{
+	arguments = nobs_array_copy(arguments);
+	nobs_array_append(&arguments, "-Wall", "-pthread");
+
+	NobsArray command = { 0 };
+	nobs_array_append(&command, NOBS_COMPILER, NOBS_OUT_OBJ(output), source);
+	nobs_array_merge(&command, arguments);
+	if (nobs_proc_run_sync(command) != 0) {
+		return 1;
+	}
+
+	// `ar` would add to the members of a previous build.
+	nobs_file_delete(nobs_string_concat(output, LIB_EXT));
+	command.count = 0;
+	nobs_array_append(&command, "ar", "rcs", nobs_string_concat(output, LIB_EXT), nobs_string_concat(output, NOBS_OBJ_EXT));
+	return nobs_proc_run_sync(command);
+}
+
+#define build_game(output, libs_dir, arguments) build_program("./game_of_life.c", output, libs_dir, arguments)
+
+// Runs the headless benchmark `arguments` with the game `exe` and returns its report: one "<mcells> <engine>" line per engine.
+static NobsString
+measure_game(NobsString exe, NobsArray arguments)
+{
+	NobsString report = "./build/bench_report.txt";
+	nobs_file_delete(report);
+
+	NobsArray command = { 0 };
+	nobs_array_append(&command, exe);
+	nobs_array_merge(&command, arguments);
+	nobs_array_append(&command, "--report", report);
+	if (nobs_proc_run_sync(command) != 0 || nobs_file_exists(report) == false) {
+		nobs_panic("Benchmark of %s failed.\n", exe);
+	}
+	return nobs_file_read(report);
+}
+
+// Profile guided and link time optimized build:
+//
+//	1. Build the plain -O2 game, and measure it.
+//	2. Build an instrumented game (and Raylib) with LTO, and run the training workload to collect a profile.
+//	3. Rebuild the same objects with the collected profile and LTO, and measure it.
+//
+// Both PGO stages must use the same output paths, since the compilers match profile data to objects by name.
+static int
+release_pgo(NobsArray arguments)
+{
+	NobsString cwd         = nobs_env_cwd();
+	NobsString profile_dir = nobs_string_format("%s/build/pgo/profile", cwd);
+	NobsString libs_dir    = "./build/libs-pgo";
+	NobsString plain_exe   = "./build/bin/game_of_life";
+	NobsString pgo_exe     = "./build/pgo/game_of_life";
+
+	nobs_file_make_dirs(profile_dir);
+
+	// Plain build.
+
+	NobsTimePoint begin = nobs_time_get_current();
+	if (build_game(plain_exe, "./build/libs", arguments) != 0) {
+		nobs_panic("Plain build failed.\n");
+	}
+	NobsString plain_time = nobs_string_get_elapsed_since(begin);
+
+	// Instrumented build, and training.
+
+	begin = nobs_time_get_current();
+
+	// Stale counters from a previous training would be merged with the new ones.
+	NobsArray command = { 0 };
+	nobs_array_append(&command, "rm", "-rf", profile_dir);
+	nobs_proc_run_sync(command);
+	nobs_file_make_dirs(profile_dir);
+
+	NobsArray instrumented = nobs_array_copy(arguments);
+	nobs_array_append(&instrumented, "-flto", nobs_string_concat("-fprofile-generate=", profile_dir));
+#if NOBS_GCC
+	nobs_array_append(&instrumented, "-fprofile-update=prefer-atomic");
+#endif
+	if (build_game(pgo_exe, libs_dir, instrumented) != 0) {
+		nobs_panic("Instrumented build failed.\n");
+	}
+
+	command.count = 0;
+	nobs_array_append(&command, pgo_exe, PGO_TRAINING_ARGS);
+	if (nobs_proc_run_sync(command) != 0) {
+		nobs_panic("Training run failed.\n");
+	}
+
+	// Optimized build.
+
+	NobsArray optimized = nobs_array_copy(arguments);
+#if NOBS_CLANG
+	NobsString profile = nobs_string_concat(profile_dir, "/default.profdata");
+	command.count = 0;
+	nobs_array_append(&command, "llvm-profdata", "merge", nobs_string_concat("-output=", profile), profile_dir);
+	if (nobs_proc_run_sync(command) != 0) {
+		nobs_panic("Merging the profile data failed.\n");
+	}
+	nobs_array_append(&optimized, "-flto", nobs_string_concat("-fprofile-use=", profile), "-Wno-profile-instr-unprofiled");
+#else
+	nobs_array_append(&optimized, "-flto", nobs_string_concat("-fprofile-use=", profile_dir), "-fprofile-correction", "-Wno-missing-profile");
+#endif
+	if (build_game(pgo_exe, libs_dir, optimized) != 0) {
+		nobs_panic("Optimized build failed.\n");
+	}
+	NobsString pgo_time = nobs_string_get_elapsed_since(begin);
+
+	// Compare.
+
+	NobsArray measure = { 0 };
+	nobs_array_append(&measure, PGO_MEASURE_ARGS);
+	NobsString plain_report = measure_game(plain_exe, measure);
+	NobsString pgo_report   = measure_game(pgo_exe, measure);
+
+	nobs_info("Plain -O2 built in %s, PGO + LTO built in %s.\n", plain_time, pgo_time);
+	nobs_info("%-12s %12s %12s %10s\n", "Engine", "-O2 Mc/s", "PGO Mc/s", "Diff");
+	char name[64];
+	double plain, pgo;
+	int plain_read, pgo_read;
+	while (sscanf(plain_report, "%lf %63s%n", &plain, name, &plain_read) == 2 &&
+		   sscanf(pgo_report, "%lf %*s%n", &pgo, &pgo_read) == 1) {
+		nobs_info("%-12s %12.2f %12.2f %+9.2f%%\n", name, plain, pgo, (pgo / plain - 1.0) * 100.0);
+		plain_report += plain_read;
+		pgo_report += pgo_read;
+	}
+	return 0;
+}
+
+
+// Returns the throughput of `engine` in a benchmark report, or 0 if it's not in there.
+static double
+report_get(NobsString report, NobsString engine)
+{
+	char name[64];
+	double mcells;
+	int read;
+	while (sscanf(report, "%lf %63s%n", &mcells, name, &read) == 2) {
+		if (nobs_string_equal(name, engine)) {
+			return mcells;
+		}
+		report += read;
+	}
+	return 0.0;
+}
+
+// Test target:
+//
+//	1. Conformance: `game_of_life --check` runs every engine on known patterns and random boards, and compares
+//	   them to the reference kernel generation by generation.
+//	2. Library conformance: `gol_check` runs the same cases through the simulation library, and compares them
+//	   to the reference hashes written by `--check-cases`.
+//	3. Performance: every engine is benchmarked (best of 3 runs), and fails if it's slower than the stored baseline by more than
+//	   `tolerance` percents. The baseline is created by the first run, and updated with `update_baseline`.
+static int
+run_tests(NobsArray arguments, double tolerance, bool update_baseline)
+{
+	NobsString exe = "./build/bin/game_of_life";
+	if (build_game(exe, "./build/libs", arguments) != 0) {
+		nobs_panic("Build failed.\n");
+	}
+
+	NobsArray gol = nobs_array_copy(arguments);
+	nobs_array_append(&gol, "./build/libs/libgol" LIB_EXT);
+	if (build_library("./gol.c", "./build/libs/libgol", arguments) != 0 || build_tool("./gol_check.c", "./build/bin/gol_check", gol) != 0) {
+		nobs_panic("Library build failed.\n");
+	}
+
+	NobsArray command = { 0 };
+	nobs_array_append(&command, exe, "--check", "--check-cases", "./build/check_cases.txt");
+	if (nobs_proc_run_sync(command) != 0) {
+		nobs_error("Conformance check failed.\n");
+		return 1;
+	}
+
+	command.count = 0;
+	nobs_array_append(&command, "./build/bin/gol_check", "./build/check_cases.txt");
+	if (nobs_proc_run_sync(command) != 0) {
+		nobs_error("Library conformance check failed.\n");
+		return 1;
+	}
+
+	// Best of 3 runs, to filter out some of the noise.
+	NobsArray bench = { 0 };
+	nobs_array_append(&bench, TEST_BENCH_ARGS);
+	NobsString runs[3];
+	for (int i = 0; i != 3; ++i) {
+		runs[i] = measure_game(exe, bench);
+	}
+	NobsString report = "";
+	char name[64];
+	double mcells;
+	int read;
+	for (NobsString run = runs[0]; sscanf(run, "%lf %63s%n", &mcells, name, &read) == 2; run += read) {
+		for (int i = 1; i != 3; ++i) {
+			double other = report_get(runs[i], name);
+			mcells = other > mcells ? other : mcells;
+		}
+		report = nobs_string_format("%s%f %s\n", report, mcells, name);
+	}
+
+	if (update_baseline || nobs_file_exists(TEST_BASELINE) == false) {
+		FILE * file = fopen(TEST_BASELINE, "wb");
+		fputs(report, file);
+		fclose(file);
+		nobs_info("Performance baseline written to %s.\n", TEST_BASELINE);
+		return 0;
+	}
+
+	NobsString baseline = nobs_file_read(TEST_BASELINE);
+	int failures = 0;
+	while (sscanf(report, "%lf %63s%n", &mcells, name, &read) == 2) {
+		double expected = report_get(baseline, name);
+		if (expected == 0.0) {
+			nobs_info("%-12s %10.2f Mcells/s, no baseline (use --update-baseline to add it)\n", name, mcells);
+		} else if (mcells < expected * (1.0 - tolerance / 100.0)) {
+			nobs_error("%-12s %10.2f Mcells/s, baseline %.2f: %+.2f%% is beyond the %.1f%% tolerance\n", name, mcells, expected,
+					   (mcells / expected - 1.0) * 100.0, tolerance);
+			++failures;
+		} else {
+			nobs_info("%-12s %10.2f Mcells/s, baseline %.2f: %+.2f%%\n", name, mcells, expected, (mcells / expected - 1.0) * 100.0);
+		}
+		report += read;
+	}
+	return failures ? 1 : 0;
+}
+
+#endif
+
 
 int
 main(int argc, char ** argv)
@@ -36,27 +318,51 @@ main(int argc, char ** argv)
 	nobs_file_make_dirs("./build/libs");
 
 	NobsArray arguments = { 0 };
-#if NOBS_WINDOWS
-	nobs_array_append(&arguments, "/Ox");
-	// nobs_array_append(&arguments, "/Z7", "/DDEBUG");
-#else
 	nobs_array_append(&arguments, "-O2");
 	// nobs_array_append(&arguments, "-g");
-#endif
-
-	NobsArray raylib = nobs_raylib(RAYLIB_DIR, "./build/libs", arguments);
 
-#if NOBS_WINDOWS
-	nobs_array_append(&arguments, "/W4", "/wd4505");
-#else
-	nobs_array_append(&arguments, "-Wall");
-#endif
-
-	NobsArray command = { 0 };
-	nobs_array_append(&command, NOBS_COMPILER, NOBS_OUT_EXE("./build/bin/game_of_life"), "./game_of_life.c");
-	nobs_array_merge(&command, arguments, raylib);
+	// Usage: nobs [release-pgo | test [--tolerance <percent>] [--update-baseline]]
+	if (argc > 1 && nobs_string_equal(argv[1], "test")) {
+		double tolerance = TEST_TOLERANCE;
+		bool update_baseline = false;
+		for (int i = 2; i < argc; ++i) {
+			if (nobs_string_equal(argv[i], "--tolerance") && i + 1 < argc) {
+				tolerance = atof(argv[++i]);
+			} else if (nobs_string_equal(argv[i], "--update-baseline")) {
+				update_baseline = true;
+			} else {
+				nobs_panic("Unknown test option '%s'.\n", argv[i]);
+			}
+		}
+		int result = run_tests(arguments, tolerance, update_baseline);
+		nobs_info("Tests %s in %s.\n", result ? "failed" : "passed", nobs_string_get_elapsed_since(begin));
+		return result;
+	}
+	if (argc > 1 && nobs_string_equal(argv[1], "release-pgo")) {
+		nobs_file_make_dirs("./build/pgo");
+		int result = release_pgo(arguments);
+		nobs_info("Release PGO pipeline finished in %s.\n", nobs_string_get_elapsed_since(begin));
+		return result;
+	}
 
-	int result = nobs_proc_run_sync(command);
+	int result = build_game("./build/bin/game_of_life", "./build/libs", arguments);
+	if (result == 0) {
+		result = build_program("./player.c", "./build/bin/player", "./build/libs", arguments);
+	}
+	if (result == 0) {
+		result = build_tool("./shm_reader.c", "./build/bin/shm_reader", arguments);
+	}
+	if (result == 0) {
+		result = build_tool("./stream_client.c", "./build/bin/stream_client", arguments);
+	}
+	if (result == 0) {
+		result = build_library("./gol.c", "./build/libs/libgol", arguments);
+	}
+	if (result == 0) {
+		NobsArray gol = nobs_array_copy(arguments);
+		nobs_array_append(&gol, "./build/libs/libgol" LIB_EXT);
+		result = build_tool("./gol_batch.c", "./build/bin/gol_batch", gol);
+	}
 	nobs_info("Build %s in %s.\n", result ? "failed" : "succeeded", nobs_string_get_elapsed_since(begin));
 	return result;
 #else
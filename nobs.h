@@ -132,7 +132,7 @@ struct NobsArray_
 static NobsArray
 nobs_array_copy(NobsArray array)
 {
-	NobsArray copy = { .data = malloc(array.count), .count = array.count, .capacity = array.count };
+	NobsArray copy = { .data = malloc(array.count * sizeof(NobsString)), .count = array.count, .capacity = array.count };
 	memcpy(copy.data, array.data, array.count * sizeof(NobsString));
 	return copy;
 }
@@ -675,7 +675,12 @@ nobs_rebuild_impl(NobsString file, int argc, char ** argv, ...)
 
 		// Create the build command.
 		NobsArray command = { 0 };
-		nobs_array_append(&command, NOBS_COMPILER, NOBS_DEBUG, NOBS_OUT_EXE(tool), file);
+		nobs_array_append(&command, NOBS_COMPILER, NOBS_OUT_EXE(tool), file);
+
+		// An empty argument would be passed as-is to the compiler, which then fails to find that "file".
+		if (NOBS_DEBUG[0] != '\0') {
+			nobs_array_append(&command, NOBS_DEBUG);
+		}
 
 		// Add the optional parameters.
 		nobs_foreach_args (argv, NobsString, arg, arg != 0) {
@@ -0,0 +1,235 @@
+#include "raylib.h"
+#include "delta.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+
+// Player for the recordings made with `game_of_life --record`.
+//
+// The recording is never loaded in memory: seeking to a generation looks up the last keyframe before it
+// in the index, and applies the following deltas until the requested generation is reached.
+
+
+static FILE *				file				= NULL;
+static DeltaFileHeader		header				= { 0 };
+static DeltaIndexEntry *	keyframes			= NULL;
+static size_t				keyframe_count		= 0;
+static uint64_t *			words				= NULL;
+static size_t				word_count			= 0;
+static uint8_t *			payload				= NULL;
+static uint64_t				generation			= 0;
+static uint64_t				last_generation		= 0;
+
+
+// Reads the record at the current position of the file. Returns false at the end of the recording.
+static bool
+read_record(DeltaRecord *record)
+{
+	if (fread(record, sizeof(*record), 1, file) != 1 || record->size > delta_encode_bound(word_count) ||
+		fread(payload, 1, record->size, file) != record->size) {
+		return false;
+	}
+	return true;
+}
+
+static bool
+apply_record(const DeltaRecord *record)
+{
+	if (record->type == DELTA_RECORD_KEYFRAME) {
+		memset(words, 0, word_count * 8);
+	}
+	if (delta_apply(payload, record->size, words, word_count) == false) {
+		fprintf(stderr, "Corrupted record at generation %llu.\n", (unsigned long long)record->generation);
+		return false;
+	}
+	generation = record->generation;
+	return true;
+}
+
+// Loads the keyframe index. If it's missing (e.g. the recording was interrupted) it's rebuilt by scanning
+// the recording. This also finds the last generation.
+static bool
+load_index(const char *path)
+{
+	FILE *index = fopen(TextFormat("%s.idx", path), "rb");
+	if (index) {
+		fseek(index, 0, SEEK_END);
+		keyframe_count = (size_t)ftell(index) / sizeof(DeltaIndexEntry);
+		fseek(index, 0, SEEK_SET);
+		keyframes = malloc((keyframe_count + 1) * sizeof(DeltaIndexEntry));
+		keyframe_count = fread(keyframes, sizeof(DeltaIndexEntry), keyframe_count, index);
+		fclose(index);
+	}
+
+	// Scan from the last indexed keyframe (or the beginning) to find the end of the recording.
+	size_t capacity = keyframe_count;
+	long offset = keyframe_count ? (long)keyframes[keyframe_count - 1].offset : (long)sizeof(DeltaFileHeader);
+	fseek(file, offset, SEEK_SET);
+
+	DeltaRecord record;
+	while (read_record(&record)) {
+		if (record.type == DELTA_RECORD_KEYFRAME && (keyframe_count == 0 || keyframes[keyframe_count - 1].offset < (uint64_t)offset)) {
+			if (keyframe_count == capacity) {
+				capacity = capacity ? capacity * 2 : 64;
+				keyframes = realloc(keyframes, capacity * sizeof(DeltaIndexEntry));
+			}
+			keyframes[keyframe_count++] = (DeltaIndexEntry){ .generation = record.generation, .offset = (uint64_t)offset };
+		}
+		last_generation = record.generation;
+		offset = ftell(file);
+	}
+
+	return keyframe_count != 0;
+}
+
+// Seeks to the last recorded generation that is not after `target`.
+static bool
+seek(uint64_t target)
+{
+	// Last keyframe not after the target.
+	size_t first = 0, last = keyframe_count;
+	while (last - first > 1) {
+		size_t middle = (first + last) / 2;
+		if (keyframes[middle].generation <= target) {
+			first = middle;
+		} else {
+			last = middle;
+		}
+	}
+
+	fseek(file, (long)keyframes[first].offset, SEEK_SET);
+	for (;;) {
+		long offset = ftell(file);
+		DeltaRecord record;
+		if (read_record(&record) == false) {
+			return true;
+		}
+		if (record.generation > target && offset != (long)keyframes[first].offset) {
+			fseek(file, offset, SEEK_SET);
+			return true;
+		}
+		if (apply_record(&record) == false) {
+			return false;
+		}
+	}
+}
+
+// Applies the next record. Returns false at the end of the recording.
+static bool
+step(void)
+{
+	DeltaRecord record;
+	return read_record(&record) && apply_record(&record);
+}
+
+static uint64_t
+population(void)
+{
+	uint64_t count = 0;
+	for (size_t i = 0; i != word_count; ++i) {
+		count += delta_popcount(words[i]);
+	}
+	return count;
+}
+
+// Same hash as `hash_cells` in the game, so that a dumped generation can be checked against the game's.
+static uint64_t
+hash(void)
+{
+	return delta_hash_cells(words, (size_t)header.width * header.height);
+}
+
+
+int
+main(int argc, char ** argv)
+{
+	if (argc != 2 && (argc != 4 || strcmp(argv[2], "--dump") != 0)) {
+		fprintf(stderr, "Usage: %s <recording> [--dump <generation>]\n", argv[0]);
+		return 1;
+	}
+
+	file = fopen(argv[1], "rb");
+	if (file == NULL || fread(&header, sizeof(header), 1, file) != 1 || header.magic != DELTA_MAGIC || header.version != DELTA_VERSION) {
+		fprintf(stderr, "'%s' is not a recording.\n", argv[1]);
+		return 1;
+	}
+
+	word_count = delta_word_count(header.width, header.height);
+	words = calloc(word_count, 8);
+	payload = malloc(delta_encode_bound(word_count));
+	if (load_index(argv[1]) == false || seek(0) == false) {
+		fprintf(stderr, "'%s' is empty or corrupted.\n", argv[1]);
+		return 1;
+	}
+
+	// Headless dump of a single generation.
+	if (argc == 4) {
+		if (seek(strtoull(argv[3], NULL, 10)) == false) {
+			return 1;
+		}
+		printf("%ux%u board, generation %llu, population %llu, hash %016llx\n", header.width, header.height,
+			   (unsigned long long)generation, (unsigned long long)population(), (unsigned long long)hash());
+		return 0;
+	}
+
+	InitWindow(800, 500, "Game of Life player.");
+	SetWindowState(FLAG_WINDOW_RESIZABLE | FLAG_WINDOW_HIGHDPI);
+	SetTargetFPS(20);
+
+	bool playing = false;
+
+	while (WindowShouldClose() == false) {
+		BeginDrawing();
+
+		// Events.
+
+		if (IsKeyPressed(KEY_SPACE)) {
+			playing = !playing;
+		}
+		if (IsKeyPressed(KEY_RIGHT)) {
+			playing = false;
+			step();
+		}
+		if (playing && step() == false) {
+			playing = false;
+		}
+		if (IsKeyPressed(KEY_LEFT) && generation > 0) {
+			seek(generation - 1);
+		}
+		if (IsKeyPressed(KEY_PAGE_UP)) {
+			seek(generation + header.keyframe_interval);
+		}
+		if (IsKeyPressed(KEY_PAGE_DOWN)) {
+			seek(generation > header.keyframe_interval ? generation - header.keyframe_interval : 0);
+		}
+		if (IsKeyPressed(KEY_HOME)) {
+			seek(0);
+		}
+		if (IsKeyPressed(KEY_END)) {
+			seek(last_generation);
+		}
+
+		// Draw cells.
+
+		ClearBackground(DARKGRAY);
+
+		Vector2 cell_size = { (float)GetRenderWidth() / header.width, (float)GetRenderHeight() / header.height };
+		for (uint32_t y = 0; y != header.height; ++y) {
+			for (uint32_t x = 0; x != header.width; ++x) {
+				size_t i = (size_t)y * header.width + x;
+				if ((words[i / 64] >> (i % 64)) & 1) {
+					DrawRectangleV((Vector2){ x * cell_size.x, y * cell_size.y }, cell_size, RAYWHITE);
+				}
+			}
+		}
+
+		DrawText(TextFormat("Generation %llu / %llu", (unsigned long long)generation, (unsigned long long)last_generation), 10, 10, 20, BLACK);
+
+		EndDrawing();
+	}
+
+	return 0;
+}
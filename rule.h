@@ -0,0 +1,131 @@
+#pragma once
+
+// Rules of the simulation, shared by the game and the library (see gol.h).
+//
+// A rule is parsed from one of 2 notations:
+//
+// - B/S (e.g. "B3/S23" for Conway's), giving the `birth` and `survive` masks where bit n is set when n neighbors
+//   give birth to / keep alive a cell.
+// - Larger than Life, as in Golly (e.g. "R5,C0,M1,S34..58,B34..45,NM" for Bosco's rule): a cell is born / survives
+//   when the number of live cells in the (2R + 1) x (2R + 1) square around it, itself included if M is 1, is in the
+//   B / S range. Only 2 states (C0 or C2) and this square (NM) neighborhood are supported. A rule of radius 1 is
+//   the same as a B/S one, and gets its masks.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+// Largest radius of the Larger than Life rules, and their largest neighborhood sum (with the cell itself).
+#define LTL_MAX_RADIUS	10
+#define LTL_MAX_COUNT	((2 * LTL_MAX_RADIUS + 1) * (2 * LTL_MAX_RADIUS + 1))
+
+#define RULE_CONWAY		{ .radius = 1, .birth = 1 << 3, .survive = (1 << 2) | (1 << 3) }
+
+typedef struct {
+	int		radius;
+	bool	middle;
+	int		birth;
+	int		survive;
+	int		birth_min;
+	int		birth_max;
+	int		survive_min;
+	int		survive_max;
+} Rule;
+
+
+// Parses `text` into `rule`. Returns false and leaves `rule` as is if it isn't a valid rule.
+static inline bool
+rule_parse(const char *text, Rule *rule)
+{
+	Rule parsed = { .radius = 1 };
+
+	int states, middle, length = 0;
+	char neighborhood;
+	if (*text == 'R' || *text == 'r') {
+		if (sscanf(text + 1, "%d,C%d,M%d,S%d..%d,B%d..%d,N%c%n", &parsed.radius, &states, &middle, &parsed.survive_min,
+				   &parsed.survive_max, &parsed.birth_min, &parsed.birth_max, &neighborhood, &length) != 8 || text[1 + length] != '\0') {
+			return false;
+		}
+		int count = (2 * parsed.radius + 1) * (2 * parsed.radius + 1);
+		if (parsed.radius < 1 || parsed.radius > LTL_MAX_RADIUS || (states != 0 && states != 2) || (middle != 0 && middle != 1) ||
+			neighborhood != 'M' || parsed.birth_min < 0 || parsed.birth_min > parsed.birth_max || parsed.birth_max > count ||
+			parsed.survive_min < 0 || parsed.survive_min > parsed.survive_max || parsed.survive_max > count) {
+			return false;
+		}
+
+		parsed.middle = middle == 1;
+		for (int n = 0; parsed.radius == 1 && n != 9; ++n) {
+			parsed.birth |= (n >= parsed.birth_min && n <= parsed.birth_max) << n;
+			parsed.survive |= (n + middle >= parsed.survive_min && n + middle <= parsed.survive_max) << n;
+		}
+		*rule = parsed;
+		return true;
+	}
+
+	if (*text != 'B' && *text != 'b') {
+		return false;
+	}
+	for (++text; *text >= '0' && *text <= '8'; ++text) {
+		parsed.birth |= 1 << (*text - '0');
+	}
+	if (*text++ != '/' || (*text != 'S' && *text != 's')) {
+		return false;
+	}
+	for (++text; *text >= '0' && *text <= '8'; ++text) {
+		parsed.survive |= 1 << (*text - '0');
+	}
+	if (*text != '\0') {
+		return false;
+	}
+	*rule = parsed;
+	return true;
+}
+
+// Formats `rule` into `out` (64 bytes are always enough), in the B/S notation, or the Larger than Life one for a
+// larger radius. Returns `out`.
+static inline char *
+rule_format(const Rule *rule, char *out, size_t size)
+{
+	if (rule->radius > 1) {
+		snprintf(out, size, "R%d,C0,M%d,S%d..%d,B%d..%d,NM", rule->radius, rule->middle ? 1 : 0, rule->survive_min,
+				 rule->survive_max, rule->birth_min, rule->birth_max);
+		return out;
+	}
+
+	char text[32], *end = text;
+	*end++ = 'B';
+	for (int n = 0; n != 9; ++n) {
+		if ((rule->birth >> n) & 1) {
+			*end++ = (char)('0' + n);
+		}
+	}
+	*end++ = '/';
+	*end++ = 'S';
+	for (int n = 0; n != 9; ++n) {
+		if ((rule->survive >> n) & 1) {
+			*end++ = (char)('0' + n);
+		}
+	}
+	*end = '\0';
+	snprintf(out, size, "%s", text);
+	return out;
+}
+
+// Fills `next`, which maps the state of a cell and the sum of its whole neighborhood (itself included) to its
+// next state, for any radius.
+static inline void
+rule_sum_table(const Rule *rule, uint8_t next[2][LTL_MAX_COUNT + 1])
+{
+	for (int alive = 0; alive != 2; ++alive) {
+		for (int sum = 0; sum <= LTL_MAX_COUNT; ++sum) {
+			int count = rule->radius > 1 && rule->middle ? sum : sum - alive;
+			if (rule->radius == 1) {
+				next[alive][sum] = count >= 0 && count <= 8 && ((alive ? rule->survive : rule->birth) >> count) & 1;
+			} else {
+				next[alive][sum] = alive ? count >= rule->survive_min && count <= rule->survive_max : count >= rule->birth_min && count <= rule->birth_max;
+			}
+		}
+	}
+}
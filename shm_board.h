@@ -0,0 +1,79 @@
+#pragma once
+
+// Shared memory export of the live board, shared by the game (`--shm <name>`) and its readers.
+//
+// The segment is made of a `ShmBoardHeader`, followed by 2 packed boards (see delta.h for the layout). Each
+// board is guarded by a seqlock: the game increments its sequence before writing it (making it odd) and after
+// (making it even again), then publishes its index in `latest`. The boards are written alternately, so the
+// game never waits for the readers, and a reader has a whole generation to read the latest board in place.
+//
+// A reader loads `latest` and the sequence of that board, reads what it needs in place, and checks that the
+// sequence is still the same (and even) afterwards. Otherwise the game wrote it in between, and it retries.
+//
+// When the size of the board changes or the game exits, the segment is marked as closed and unlinked. Readers
+// then need to open it again (a new segment with the same name is created when the board is resized).
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+#define SHM_BOARD_MAGIC		0x534c4f47 // "GOLS"
+#define SHM_BOARD_VERSION	1
+
+typedef struct {
+	_Atomic uint64_t	sequence;
+	uint64_t			generation;
+	uint64_t			population;
+	uint64_t			reserved;
+} ShmBoardBuffer;
+
+typedef struct {
+	uint32_t			magic;
+	uint32_t			version;
+	uint64_t			width;
+	uint64_t			height;
+	uint64_t			word_count;
+	_Atomic uint32_t	closed;
+	_Atomic uint32_t	latest;
+	uint64_t			reserved[2];
+	ShmBoardBuffer		buffers[2];
+} ShmBoardHeader;
+
+
+// Size of the segment for boards of `word_count` words.
+static inline size_t
+shm_board_size(size_t word_count)
+{
+	return sizeof(ShmBoardHeader) + 2 * word_count * 8;
+}
+
+// Packed board of the buffer `index`.
+static inline uint64_t *
+shm_board_words(ShmBoardHeader *header, uint32_t index)
+{
+	return (uint64_t *)(header + 1) + index * header->word_count;
+}
+
+// Reader side: returns the index of the latest board and its sequence, to pass to `shm_board_read_end`.
+static inline uint32_t
+shm_board_read_begin(ShmBoardHeader *header, uint64_t *sequence)
+{
+	for (;;) {
+		uint32_t index = atomic_load_explicit(&header->latest, memory_order_acquire);
+		*sequence = atomic_load_explicit(&header->buffers[index].sequence, memory_order_acquire);
+		if ((*sequence & 1) == 0) {
+			return index;
+		}
+	}
+}
+
+// Reader side: returns true if the board `index` wasn't written since `shm_board_read_begin`, meaning that
+// what was read is consistent.
+static inline bool
+shm_board_read_end(ShmBoardHeader *header, uint32_t index, uint64_t sequence)
+{
+	atomic_thread_fence(memory_order_acquire);
+	return atomic_load_explicit(&header->buffers[index].sequence, memory_order_relaxed) == sequence;
+}
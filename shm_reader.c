@@ -0,0 +1,138 @@
+#include "delta.h"
+#include "shm_board.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+// Reference reader of the board exported by `game_of_life --shm <name>` (see shm_board.h).
+//
+// Prints the size, generation, population and hash of the latest board, or of every new generation with
+// `--watch`. The hash is the same as the game's `hash_cells` and the player's `--dump`, so that snapshots can
+// be compared with recordings. The board is read in place, without copying it.
+
+
+typedef struct {
+	uint64_t	generation;
+	uint64_t	population;
+	uint64_t	hash;
+	uint64_t	counted;
+	uint64_t	retries;
+} Snapshot;
+
+
+// Maps the segment `name`. Returns NULL if it doesn't exist (yet) or doesn't hold a board yet.
+static ShmBoardHeader *
+open_board(const char *name, size_t *size)
+{
+	int fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0) {
+		return NULL;
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(ShmBoardHeader)) {
+		close(fd);
+		return NULL;
+	}
+	*size = (size_t)info.st_size;
+	ShmBoardHeader *header = mmap(NULL, *size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (header == MAP_FAILED) {
+		return NULL;
+	}
+
+	// The magic is written last by the game.
+	if (header->magic != SHM_BOARD_MAGIC || header->version != SHM_BOARD_VERSION || shm_board_size(header->word_count) > *size) {
+		munmap(header, *size);
+		return NULL;
+	}
+	atomic_thread_fence(memory_order_acquire);
+	return header;
+}
+
+// Reads a consistent snapshot of the latest board, retrying while the game overwrites it.
+static void
+read_snapshot(ShmBoardHeader *header, Snapshot *snapshot)
+{
+	snapshot->retries = 0;
+	for (;;) {
+		uint64_t sequence;
+		uint32_t index = shm_board_read_begin(header, &sequence);
+		const uint64_t *words = shm_board_words(header, index);
+
+		snapshot->generation = header->buffers[index].generation;
+		snapshot->population = header->buffers[index].population;
+		size_t size = (size_t)(header->width * header->height);
+		snapshot->hash = delta_hash_cells(words, size);
+		snapshot->counted = 0;
+		for (size_t i = 0; i != delta_word_count(size, 1); ++i) {
+			snapshot->counted += delta_popcount(words[i]);
+		}
+
+		if (shm_board_read_end(header, index, sequence)) {
+			return;
+		}
+		++snapshot->retries;
+	}
+}
+
+
+int
+main(int argc, char ** argv)
+{
+	bool watch = argc == 3 && strcmp(argv[2], "--watch") == 0;
+	if (argc != 2 && watch == false) {
+		fprintf(stderr, "Usage: %s <name> [--watch]\n", argv[0]);
+		return 1;
+	}
+
+	size_t size = 0;
+	ShmBoardHeader *header = open_board(argv[1], &size);
+	if (header == NULL) {
+		fprintf(stderr, "No board is exported as '%s'.\n", argv[1]);
+		return 1;
+	}
+
+	uint64_t last = UINT64_MAX;
+	for (;;) {
+		// The game resized the board or exited: wait a bit for a new segment.
+		if (atomic_load_explicit(&header->closed, memory_order_acquire)) {
+			munmap(header, size);
+			header = NULL;
+			for (int i = 0; watch && header == NULL && i != 200; ++i) {
+				sleep_ms(10);
+				header = open_board(argv[1], &size);
+			}
+			if (header == NULL) {
+				printf("Board closed.\n");
+				return 0;
+			}
+			last = UINT64_MAX;
+		}
+
+		Snapshot snapshot;
+		read_snapshot(header, &snapshot);
+		if (snapshot.generation != last) {
+			printf("%llux%llu board, generation %llu, population %llu, hash %016llx (%llu retries)\n",
+				   (unsigned long long)header->width, (unsigned long long)header->height, (unsigned long long)snapshot.generation,
+				   (unsigned long long)snapshot.population, (unsigned long long)snapshot.hash, (unsigned long long)snapshot.retries);
+			if (snapshot.counted != snapshot.population) {
+				fprintf(stderr, "Inconsistent snapshot: %llu live cells counted.\n", (unsigned long long)snapshot.counted);
+				return 1;
+			}
+			last = snapshot.generation;
+		}
+
+		if (watch == false) {
+			return 0;
+		}
+		sleep_ms(10);
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+// Protocol of the streaming server of the game (`--serve <path>`), shared with its clients.
+//
+// The server listens on a Unix domain socket, and sends each client a sequence of messages, each made of a
+// `StreamMessage` followed by `size` bytes of payload: a packed board encoded with `delta_encode` (see
+// delta.h). The first message is a keyframe (the delta against an empty board), and the following ones are
+// deltas against the previous message's board, so a client reconstructs every board by XORing them in order.
+//
+// Generations can be skipped when the simulation runs faster than the server, and a client that can't keep
+// up gets a keyframe instead of the deltas it missed. A keyframe is also sent when the size of the board
+// changes. Each message has the hash and population of its board, so that clients can check it.
+
+#include "delta.h"
+
+
+#define STREAM_MAGIC	0x544c4f47 // "GOLT"
+
+enum {
+	STREAM_DELTA	= 0,
+	STREAM_KEYFRAME	= 1,
+};
+
+typedef struct {
+	uint32_t	magic;
+	uint32_t	type;
+	uint32_t	width;
+	uint32_t	height;
+	uint64_t	generation;
+	uint64_t	population;
+	uint64_t	hash;
+	uint64_t	size;
+} StreamMessage;
+
+
+// FNV-1a hash of the words of a packed board.
+static inline uint64_t
+stream_hash(const uint64_t *words, size_t count)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (size_t i = 0; i != count; ++i) {
+		hash = (hash ^ words[i]) * 0x100000001b3ull;
+	}
+	return hash;
+}
@@ -0,0 +1,124 @@
+#include "stream.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+
+// Test client of the streaming server (`game_of_life --serve <path>`, see stream.h).
+//
+// Reconstructs every board from the stream, and checks its hash and population against the ones the server
+// sent with it. `--count` stops after a number of messages, and `--delay` waits after each message to act
+// as a slow client, which the server should resynchronize with keyframes.
+
+
+static bool
+receive(int socket, void *data, size_t size)
+{
+	for (uint8_t *bytes = data; size != 0;) {
+		ssize_t received = recv(socket, bytes, size, 0);
+		if (received <= 0) {
+			return false;
+		}
+		bytes += received;
+		size -= (size_t)received;
+	}
+	return true;
+}
+
+
+int
+main(int argc, char ** argv)
+{
+	uint64_t count = UINT64_MAX;
+	int delay = 0;
+	for (int i = 2; i < argc; ++i) {
+		if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+			count = strtoull(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--delay") == 0 && i + 1 < argc) {
+			delay = atoi(argv[++i]);
+		} else {
+			argc = 0;
+		}
+	}
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <socket> [--count <messages>] [--delay <ms>]\n", argv[0]);
+		return 1;
+	}
+
+	struct sockaddr_un address = { .sun_family = AF_UNIX };
+	strncpy(address.sun_path, argv[1], sizeof(address.sun_path) - 1);
+	int server = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (server < 0 || connect(server, (struct sockaddr *)&address, sizeof(address)) != 0) {
+		fprintf(stderr, "Couldn't connect to '%s'.\n", argv[1]);
+		return 1;
+	}
+
+	uint64_t *words = NULL;
+	size_t word_count = 0;
+	uint8_t *payload = NULL;
+	uint64_t messages = 0, keyframes = 0, first = 0, last = 0;
+
+	StreamMessage message;
+	while (messages != count && receive(server, &message, sizeof(message))) {
+		if (message.magic != STREAM_MAGIC) {
+			fprintf(stderr, "Invalid message after %llu message(s).\n", (unsigned long long)messages);
+			return 1;
+		}
+
+		size_t message_words = delta_word_count(message.width, message.height);
+		if (message.type == STREAM_KEYFRAME) {
+			if (message_words != word_count) {
+				word_count = message_words;
+				words = realloc(words, word_count * 8);
+				payload = realloc(payload, delta_encode_bound(word_count));
+			}
+			memset(words, 0, word_count * 8);
+			++keyframes;
+		} else if (words == NULL || message_words != word_count) {
+			fprintf(stderr, "Delta for generation %llu without a keyframe of its size.\n", (unsigned long long)message.generation);
+			return 1;
+		}
+
+		// The server may exit in the middle of a message.
+		if (message.size <= delta_encode_bound(word_count) && receive(server, payload, message.size) == false) {
+			break;
+		}
+		if (message.size > delta_encode_bound(word_count) || delta_apply(payload, message.size, words, word_count) == false) {
+			fprintf(stderr, "Corrupted message for generation %llu.\n", (unsigned long long)message.generation);
+			return 1;
+		}
+
+		uint64_t population = 0;
+		for (size_t i = 0; i != word_count; ++i) {
+			population += delta_popcount(words[i]);
+		}
+		if (stream_hash(words, word_count) != message.hash || population != message.population) {
+			fprintf(stderr, "Generation %llu doesn't match: population %llu instead of %llu.\n", (unsigned long long)message.generation,
+					(unsigned long long)population, (unsigned long long)message.population);
+			return 1;
+		}
+
+		first = messages == 0 ? message.generation : first;
+		last = message.generation;
+		++messages;
+		if (delay) {
+			sleep_ms(delay);
+		}
+	}
+
+	if (messages == 0) {
+		fprintf(stderr, "The server closed the connection without sending any message (it may have too many clients).\n");
+		close(server);
+		return 1;
+	}
+	printf("%llu message(s), %llu keyframe(s), generations %llu to %llu: all boards match\n", (unsigned long long)messages,
+		   (unsigned long long)keyframes, (unsigned long long)first, (unsigned long long)last);
+	close(server);
+	return 0;
+}